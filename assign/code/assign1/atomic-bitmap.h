@@ -0,0 +1,68 @@
+/**
+ * File: atomic-bitmap.h
+ * ---------------------
+ * Exports the atomicBitmap class, a fixed-size array of bits that any number
+ * of threads can set concurrently.  It's used as the visited set of the
+ * parallel graph searches, where several threads race to claim the same
+ * actor or film and exactly one of them must win.
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+class atomicBitmap {
+ public:
+
+/**
+ * Constructor: atomicBitmap
+ * -------------------------
+ * Constructs a bitmap of the specified size with all bits cleared.
+ */
+  atomicBitmap(size_t numBits) :
+    numWords((numBits + kBitsPerWord - 1) / kBitsPerWord), words(new std::atomic<uint64_t>[numWords]()) {}
+
+/**
+ * Method: testAndSet
+ * ------------------
+ * Sets the specified bit and returns whether it was already set beforehand.
+ * Of any number of threads calling testAndSet on the same bit, exactly one
+ * sees false.
+ */
+  bool testAndSet(size_t bit) {
+    uint64_t mask = uint64_t(1) << (bit % kBitsPerWord);
+    return words[bit / kBitsPerWord].fetch_or(mask, std::memory_order_relaxed) & mask;
+  }
+
+/**
+ * Method: test
+ * ------------
+ * Returns whether the specified bit is set.
+ */
+  bool test(size_t bit) const {
+    uint64_t mask = uint64_t(1) << (bit % kBitsPerWord);
+    return words[bit / kBitsPerWord].load(std::memory_order_relaxed) & mask;
+  }
+
+/**
+ * Method: count
+ * -------------
+ * Returns the number of bits currently set.  Not meant to be called
+ * while other threads are still setting bits.
+ */
+  size_t count() const {
+    size_t total = 0;
+    for (size_t i = 0; i < numWords; i++) total += __builtin_popcountll(words[i].load(std::memory_order_relaxed));
+    return total;
+  }
+
+ private:
+  static const size_t kBitsPerWord = 64;
+  size_t numWords;
+  std::unique_ptr<std::atomic<uint64_t>[]> words;
+
+  atomicBitmap(const atomicBitmap& original) = delete;
+  atomicBitmap& operator=(const atomicBitmap& rhs) = delete;
+};
@@ -0,0 +1,141 @@
+/**
+ * File: bacon-numbers.cc
+ * ----------------------
+ * Whole-graph analytics mode: computes the distance (in films) from one
+ * actor/actress to every other actor in the imdb and prints the
+ * distribution, one line per hop count, followed by the number of actors
+ * who can't be reached at all:
+ *
+ *     Kevin Bacon: 1843122 of 1843512 actors reachable, average distance 3.0194
+ *     0	1
+ *     1	2904
+ *     2	241113
+ *     ...
+ *     unreachable	390
+ *
+ * If --distances=<file> is supplied, every actor's distance is also written to
+ * that file, one "name<TAB>distance" line per actor in alphabetical order,
+ * with -1 standing in for unreachable actors.  The search itself is a single
+ * breadth-first search over the graph index, with every level spread across
+ * --threads=<n> worker threads (one per core by default).
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "imdb.h"
+#include "graph.h"
+
+using namespace std;
+
+static const int kWrongArgumentCount = 1;
+static const int kDatabaseNotFound = 2;
+static const int kUnrecognizedFlag = 3;
+static const int kActorNotFound = 4;
+static const int kDistanceFileNotWritten = 5;
+
+static const string kThreadsFlag = "--threads=";
+static const string kDistancesFlag = "--distances=";
+static const string kDefaultActor = "Kevin Bacon";
+
+static double millisecondsSince(const chrono::steady_clock::time_point& start) {
+  return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Function: printHistogram
+ * ------------------------
+ * Prints the summary line and per-hop histogram described in the file header.
+ */
+static void printHistogram(const string& player, const vector<uint8_t>& distances) {
+  vector<size_t> histogram;
+  size_t unreachable = 0;
+  double total = 0;
+  for (uint8_t distance: distances) {
+    if (distance == kUnreachableDistance) {
+      unreachable++;
+      continue;
+    }
+    if (distance >= histogram.size()) histogram.resize(distance + 1, 0);
+    histogram[distance]++;
+    total += distance;
+  }
+
+  size_t reachable = distances.size() - unreachable;
+  cout << player << ": " << reachable << " of " << distances.size() << " actors reachable, average distance "
+       << (reachable > 1 ? total / (reachable - 1) : 0) << endl;
+  for (size_t hops = 0; hops < histogram.size(); hops++) cout << hops << "\t" << histogram[hops] << endl;
+  cout << "unreachable\t" << unreachable << endl;
+}
+
+/**
+ * Function: writeDistances
+ * ------------------------
+ * Writes the per-actor distance file described in the file header, returning
+ * true if and only if every line made it out.
+ */
+static bool writeDistances(const imdb& db, const vector<uint8_t>& distances, const string& fileName) {
+  ofstream out(fileName);
+  for (size_t actor = 0; actor < distances.size() && out; actor++) {
+    out << db.getPlayerView(db.getPlayerOffset(actor)) << '\t';
+    if (distances[actor] == kUnreachableDistance) out << "-1\n";
+    else out << (int) distances[actor] << '\n';
+  }
+  out.close();
+  return !out.fail();
+}
+
+int main(int argc, char *argv[]) {
+  size_t numThreads = thread::hardware_concurrency();
+  if (numThreads == 0) numThreads = 1;
+  string distanceFileName;
+  int argIndex = 1;
+  for (; argIndex < argc && string(argv[argIndex]).compare(0, 2, "--") == 0; argIndex++) {
+    const string flag = argv[argIndex];
+    if (flag.compare(0, kThreadsFlag.size(), kThreadsFlag) == 0 && atoi(argv[argIndex] + kThreadsFlag.size()) > 0) {
+      numThreads = atoi(argv[argIndex] + kThreadsFlag.size());
+    } else if (flag.compare(0, kDistancesFlag.size(), kDistancesFlag) == 0 && flag.size() > kDistancesFlag.size()) {
+      distanceFileName = flag.substr(kDistancesFlag.size());
+    } else {
+      cerr << "Usage: " << argv[0] << " [" << kThreadsFlag << "<n>] [" << kDistancesFlag << "<file>] [<actor>]" << endl;
+      return kUnrecognizedFlag;
+    }
+  }
+
+  if (argc - argIndex > 1) {
+    cerr << "Usage: " << argv[0] << " [" << kThreadsFlag << "<n>] [" << kDistancesFlag << "<file>] [<actor>]" << endl;
+    return kWrongArgumentCount;
+  }
+
+  imdb db(kIMDBDataDirectory);
+  if (!db.good()) {
+    cerr << "Data directory not found!  Aborting..." << endl;
+    return kDatabaseNotFound;
+  }
+
+  const string player = argIndex < argc ? argv[argIndex] : kDefaultActor;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  graph g(db);
+  cerr << "Graph built in " << millisecondsSince(start) << " ms." << endl;
+  int source = g.findActor(player);
+  if (source < 0) {
+    cerr << player << " isn't in the database." << endl;
+    return kActorNotFound;
+  }
+
+  vector<uint8_t> distances;
+  start = chrono::steady_clock::now();
+  g.computeDistancesInParallel(source, numThreads, distances);
+  cerr << "Distances computed in " << millisecondsSince(start) << " ms on " << numThreads << " threads." << endl;
+  printHistogram(player, distances);
+
+  if (!distanceFileName.empty() && !writeDistances(db, distances, distanceFileName)) {
+    cerr << "Failed to write distances to " << distanceFileName << "." << endl;
+    return kDistanceFileNotWritten;
+  }
+  return 0;
+}
@@ -0,0 +1,43 @@
+/**
+ * File: build-fuzzy-index.cc
+ * --------------------------
+ * Offline tool that builds the trigram index behind fuzzy actor lookups (see
+ * fuzzy-index.h) and writes it alongside the imdb's data files.
+ */
+
+#include <iostream>
+#include "imdb.h"
+#include "fuzzy-index.h"
+
+using namespace std;
+
+static const int kWrongArgumentCount = 1;
+static const int kDatabaseNotFound = 2;
+static const int kIndexNotWritten = 4;
+
+int main(int argc, char *argv[]) {
+  if (argc != 1) {
+    cerr << "Usage: " << argv[0] << endl;
+    return kWrongArgumentCount;
+  }
+
+  imdb db(kIMDBDataDirectory);
+  if (!db.good()) {
+    cerr << "Data directory not found!  Aborting..." << endl;
+    return kDatabaseNotFound;
+  }
+
+  if (!fuzzyIndex::build(db, kIMDBDataDirectory)) {
+    cerr << "Failed to write the trigram index to " << kIMDBDataDirectory << "." << endl;
+    return kIndexNotWritten;
+  }
+
+  fuzzyIndex index(kIMDBDataDirectory, db);
+  if (!index.good()) {
+    cerr << "The trigram index was written but couldn't be reopened." << endl;
+    return kIndexNotWritten;
+  }
+
+  cout << "Indexed the names of " << db.getNumPlayers() << " actors." << endl;
+  return 0;
+}
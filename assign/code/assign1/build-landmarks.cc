@@ -0,0 +1,60 @@
+/**
+ * File: build-landmarks.cc
+ * ------------------------
+ * Offline tool that builds the landmark distance index used by
+ * search --distance and writes it next to the imdb's data files.
+ * See landmarks.h for what the index holds and how it's used.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "imdb.h"
+#include "landmarks.h"
+
+using namespace std;
+
+static const int kDatabaseNotFound = 2;
+static const int kUnrecognizedFlag = 3;
+static const int kIndexNotWritten = 4;
+
+static const string kLandmarksFlag = "--landmarks=";
+static const string kThreadsFlag = "--threads=";
+static const size_t kDefaultNumLandmarks = 16;
+
+int main(int argc, char *argv[]) {
+  size_t numLandmarks = kDefaultNumLandmarks;
+  size_t numThreads = thread::hardware_concurrency();
+  if (numThreads == 0) numThreads = 1;
+  for (int i = 1; i < argc; i++) {
+    const string flag = argv[i];
+    if (flag.compare(0, kLandmarksFlag.size(), kLandmarksFlag) == 0 && atoi(argv[i] + kLandmarksFlag.size()) > 0) {
+      numLandmarks = atoi(argv[i] + kLandmarksFlag.size());
+    } else if (flag.compare(0, kThreadsFlag.size(), kThreadsFlag) == 0 && atoi(argv[i] + kThreadsFlag.size()) > 0) {
+      numThreads = atoi(argv[i] + kThreadsFlag.size());
+    } else {
+      cerr << "Usage: " << argv[0] << " [" << kLandmarksFlag << "<k>] [" << kThreadsFlag << "<n>]" << endl;
+      return kUnrecognizedFlag;
+    }
+  }
+
+  imdb db(kIMDBDataDirectory);
+  if (!db.good()) {
+    cerr << "Data directory not found!  Aborting..." << endl;
+    return kDatabaseNotFound;
+  }
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  if (!landmarkIndex::build(db, numLandmarks, numThreads, kIMDBDataDirectory)) {
+    cerr << "Failed to write the landmark index to " << kIMDBDataDirectory << "." << endl;
+    return kIndexNotWritten;
+  }
+
+  landmarkIndex index(kIMDBDataDirectory, db);
+  double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  cout << "Indexed " << db.getNumPlayers() << " actors against " << index.getNumLandmarks()
+       << " landmarks in " << elapsed << " seconds." << endl;
+  return 0;
+}
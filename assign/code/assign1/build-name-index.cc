@@ -0,0 +1,44 @@
+/**
+ * File: build-name-index.cc
+ * -------------------------
+ * Offline tool that builds the hashed name index (see name-index.h) for the
+ * imdb's data files and writes it alongside them.  Every imdb opened on that
+ * directory from then on uses it automatically.
+ */
+
+#include <iostream>
+#include "imdb.h"
+#include "name-index.h"
+
+using namespace std;
+
+static const int kWrongArgumentCount = 1;
+static const int kDatabaseNotFound = 2;
+static const int kIndexNotWritten = 4;
+
+int main(int argc, char *argv[]) {
+  if (argc != 1) {
+    cerr << "Usage: " << argv[0] << endl;
+    return kWrongArgumentCount;
+  }
+
+  imdb db(kIMDBDataDirectory);
+  if (!db.good()) {
+    cerr << "Data directory not found!  Aborting..." << endl;
+    return kDatabaseNotFound;
+  }
+
+  if (!nameIndex::build(db, kIMDBDataDirectory)) {
+    cerr << "Failed to write the name index to " << kIMDBDataDirectory << "." << endl;
+    return kIndexNotWritten;
+  }
+
+  imdb indexed(kIMDBDataDirectory);
+  if (!indexed.hasNameIndex()) {
+    cerr << "The name index was written but couldn't be reopened." << endl;
+    return kIndexNotWritten;
+  }
+
+  cout << "Indexed " << db.getNumPlayers() << " actors and " << db.getNumFilms() << " films." << endl;
+  return 0;
+}
@@ -0,0 +1,98 @@
+/**
+ * File: convert-imdb.cc
+ * ---------------------
+ * Offline tool that converts the actordata and moviedata files into the
+ * single compactdata file described in imdb.h, then reopens the result and
+ * checks that it serves up exactly the same records.  Once compactdata
+ * exists, every imdb opened on that directory uses it instead of the
+ * original files (which may then be deleted), so compactdata should be
+ * removed before converting again.
+ */
+
+#include <iostream>
+#include <string>
+#include "imdb.h"
+
+using namespace std;
+
+static const int kWrongArgumentCount = 1;
+static const int kDatabaseNotFound = 2;
+static const int kConversionFailed = 4;
+
+/**
+ * Function: sameLists
+ * -------------------
+ * Returns true if and only if the two offset lists name the same records in
+ * the same order, given that offsets are only meaningful to their own imdbs.
+ */
+template <typename Decoder>
+static bool sameLists(const imdb& original, const offsetList& originalOffsets,
+                      const imdb& converted, const offsetList& convertedOffsets) {
+  if (originalOffsets.size() != convertedOffsets.size()) return false;
+  offsetList::iterator curr = convertedOffsets.begin();
+  for (int offset: originalOffsets) {
+    if (!(Decoder()(&original, offset) == Decoder()(&converted, *curr))) return false;
+    ++curr;
+  }
+  return true;
+}
+
+/**
+ * Function: verifyConversion
+ * --------------------------
+ * Confirms record by record that converted holds everything original does.
+ */
+static bool verifyConversion(const imdb& original, const imdb& converted) {
+  if (!converted.isCompact() || original.getNumPlayers() != converted.getNumPlayers() ||
+      original.getNumFilms() != converted.getNumFilms()) return false;
+
+  for (int i = 0; i < original.getNumPlayers(); i++) {
+    int offset = original.getPlayerOffset(i), convertedOffset = converted.getPlayerOffset(i);
+    if (original.getPlayerView(offset) != converted.getPlayerView(convertedOffset) ||
+        !sameLists<filmDecoder>(original, original.getCreditOffsets(offset),
+                                converted, converted.getCreditOffsets(convertedOffset))) return false;
+  }
+
+  for (int i = 0; i < original.getNumFilms(); i++) {
+    int offset = original.getFilmOffset(i), convertedOffset = converted.getFilmOffset(i);
+    if (!(original.getFilmView(offset) == converted.getFilmView(convertedOffset)) ||
+        !sameLists<playerDecoder>(original, original.getCastOffsets(offset),
+                                  converted, converted.getCastOffsets(convertedOffset))) return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 1) {
+    cerr << "Usage: " << argv[0] << endl;
+    return kWrongArgumentCount;
+  }
+
+  imdb db(kIMDBDataDirectory);
+  if (!db.good()) {
+    cerr << "Data directory not found!  Aborting..." << endl;
+    return kDatabaseNotFound;
+  }
+
+  if (db.isCompact()) {
+    cout << "The data in " << kIMDBDataDirectory << " is already in the compact format." << endl;
+    return 0;
+  }
+
+  if (!db.writeCompact(kIMDBDataDirectory)) {
+    cerr << "Failed to write the compact data file to " << kIMDBDataDirectory << "." << endl;
+    return kConversionFailed;
+  }
+
+  imdb converted(kIMDBDataDirectory);
+  if (!converted.good() || !verifyConversion(db, converted)) {
+    cerr << "The compact data file doesn't match the original data!" << endl;
+    return kConversionFailed;
+  }
+
+  size_t originalSize = db.getActorFileSize() + db.getMovieFileSize();
+  cout << "Converted " << db.getNumPlayers() << " actors and " << db.getNumFilms() << " films: "
+       << originalSize << " bytes -> " << converted.getCompactFileSize() << " bytes ("
+       << 100.0 * converted.getCompactFileSize() / originalSize << "%)." << endl;
+  return 0;
+}
@@ -0,0 +1,87 @@
+/**
+ * File: find-actor.cc
+ * -------------------
+ * Looks up actors/actresses by approximate name.  By default, prints the
+ * actors whose names are within --edits=<k> typos (2 by default) of the one
+ * supplied, closest first, which requires the trigram index written by
+ * build-fuzzy-index.  With --prefix, prints the actors whose names begin with
+ * the text supplied instead.  Either way, at most --limit=<n> (10 by default)
+ * actors are listed, each with the number of films they've appeared in.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "imdb.h"
+#include "fuzzy-index.h"
+
+using namespace std;
+
+static const int kWrongArgumentCount = 1;
+static const int kDatabaseNotFound = 2;
+static const int kUnrecognizedFlag = 3;
+static const int kIndexNotFound = 4;
+
+static const string kPrefixFlag = "--prefix";
+static const string kEditsFlag = "--edits=";
+static const string kLimitFlag = "--limit=";
+static const int kDefaultMaxEdits = 2;
+static const size_t kDefaultMaxResults = 10;
+
+static void printUsage(const char *progname) {
+  cerr << "Usage: " << progname << " [" << kPrefixFlag << " | " << kEditsFlag << "<k>] ["
+       << kLimitFlag << "<n>] <name>" << endl;
+}
+
+int main(int argc, char *argv[]) {
+  bool prefix = false;
+  int maxEdits = kDefaultMaxEdits;
+  size_t maxResults = kDefaultMaxResults;
+  int argIndex = 1;
+  for (; argIndex < argc && string(argv[argIndex]).compare(0, 2, "--") == 0; argIndex++) {
+    const string flag = argv[argIndex];
+    if (flag == kPrefixFlag) {
+      prefix = true;
+    } else if (flag.compare(0, kEditsFlag.size(), kEditsFlag) == 0 && atoi(argv[argIndex] + kEditsFlag.size()) >= 0) {
+      maxEdits = atoi(argv[argIndex] + kEditsFlag.size());
+    } else if (flag.compare(0, kLimitFlag.size(), kLimitFlag) == 0 && atoi(argv[argIndex] + kLimitFlag.size()) > 0) {
+      maxResults = atoi(argv[argIndex] + kLimitFlag.size());
+    } else {
+      printUsage(argv[0]);
+      return kUnrecognizedFlag;
+    }
+  }
+
+  if (argc - argIndex != 1) {
+    printUsage(argv[0]);
+    return kWrongArgumentCount;
+  }
+
+  imdb db(kIMDBDataDirectory);
+  if (!db.good()) {
+    cerr << "Data directory not found!  Aborting..." << endl;
+    return kDatabaseNotFound;
+  }
+
+  fuzzyIndex index(kIMDBDataDirectory, db);
+  if (!prefix && !index.good()) {
+    cerr << "No trigram index found.  Run build-fuzzy-index first." << endl;
+    return kIndexNotFound;
+  }
+
+  const string name = argv[argIndex];
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  vector<fuzzyIndex::match> matches = prefix ? index.findPrefix(name, maxResults)
+                                             : index.findSimilar(name, maxEdits, maxResults);
+  double elapsed = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+
+  for (const fuzzyIndex::match& m: matches) {
+    cout << db.getPlayerView(m.offset) << " (";
+    if (!prefix) cout << m.distance << (m.distance == 1 ? " edit, " : " edits, ");
+    cout << db.getCreditOffsets(m.offset).size() << " films)" << endl;
+  }
+  cerr << matches.size() << (matches.size() == 1 ? " match" : " matches") << " found in " << elapsed << " us." << endl;
+  return 0;
+}
@@ -0,0 +1,253 @@
+/**
+ * File: fuzzy-index.cc
+ * --------------------
+ * Presents the implementation of the fuzzyIndex class.  The trigramindex
+ * file is laid out as follows:
+ *
+ *     header:   magic string, actor/trigram/posting counts (uint32_t each),
+ *               and the stamp of the data files indexed (see dataStamp)
+ *     keys:     every trigram that occurs anywhere, in increasing order, with
+ *               its three characters packed into the low 24 bits of a uint32_t
+ *     starts:   where each trigram's postings begin (plus one final entry)
+ *     postings: actor indices, ascending within each trigram's list
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <fcntl.h>
+#include <unistd.h>
+#include "fuzzy-index.h"
+using namespace std;
+
+static const char *const kTrigramFileName = "trigramindex";
+static const char kTrigramMagic[8] = {'T', 'R', 'I', 'G', 'R', 'A', 'M', '2'};
+static const char kPadding = ' ';
+
+struct trigramHeader {
+  char magic[8];
+  uint32_t numPlayers;
+  uint32_t numTrigrams;
+  uint32_t numPostings;
+  uint32_t unused;
+  dataStamp stamp;
+};
+
+/**
+ * Function: foldCase
+ * ------------------
+ * Lowercases ASCII letters and leaves every other byte alone.
+ */
+static inline unsigned char foldCase(char ch) {
+  return tolower((unsigned char) ch);
+}
+
+/**
+ * Function: trigramsOf
+ * --------------------
+ * Returns the distinct trigrams of the case-folded, padded name, sorted.
+ */
+static vector<uint32_t> trigramsOf(string_view name) {
+  string padded(2, kPadding);
+  for (char ch: name) padded += foldCase(ch);
+  padded.append(2, kPadding);
+
+  vector<uint32_t> trigrams;
+  for (size_t i = 0; i + 3 <= padded.size(); i++) {
+    trigrams.push_back((uint32_t) (unsigned char) padded[i] << 16 |
+                       (uint32_t) (unsigned char) padded[i + 1] << 8 |
+                       (unsigned char) padded[i + 2]);
+  }
+  sort(trigrams.begin(), trigrams.end());
+  trigrams.erase(unique(trigrams.begin(), trigrams.end()), trigrams.end());
+  return trigrams;
+}
+
+/**
+ * Function: editDistance
+ * ----------------------
+ * Returns the case-insensitive Levenshtein distance between a and b, or any
+ * number larger than maxEdits once it's clear the distance exceeds maxEdits.
+ * Only the diagonal band of cells within maxEdits of the main diagonal can
+ * hold a distance of maxEdits or less, so cells outside it are never computed.
+ * previous and current are scratch rows, passed in so they can be reused.
+ */
+static int editDistance(string_view a, string_view b, int maxEdits, vector<int>& previous, vector<int>& current) {
+  int m = a.size(), n = b.size();
+  if (abs(m - n) > maxEdits) return maxEdits + 1;
+  const int kOutOfBand = maxEdits + 1;
+  previous.assign(n + 1, kOutOfBand);
+  current.assign(n + 1, kOutOfBand);
+  for (int j = 0; j <= min(n, maxEdits); j++) previous[j] = j;
+  for (int i = 1; i <= m; i++) {
+    int first = max(1, i - maxEdits), last = min(n, i + maxEdits);
+    current[first - 1] = (first == 1 && i <= maxEdits) ? i : kOutOfBand;
+    int best = current[first - 1];
+    for (int j = first; j <= last; j++) {
+      int substitution = previous[j - 1] + (foldCase(a[i - 1]) != foldCase(b[j - 1]));
+      current[j] = min(min(substitution, min(previous[j], current[j - 1]) + 1), kOutOfBand);
+      best = min(best, current[j]);
+    }
+    if (last < n) current[last + 1] = kOutOfBand;
+    if (best > maxEdits) return maxEdits + 1;
+    previous.swap(current);
+  }
+  return previous[n];
+}
+
+bool fuzzyIndex::build(const imdb& db, const string& directory) {
+  // first pass counts each trigram's postings, second pass fills them in actor order
+  int numPlayers = db.getNumPlayers();
+  unordered_map<uint32_t, uint32_t> counts;
+  for (int i = 0; i < numPlayers; i++) {
+    for (uint32_t trigram: trigramsOf(db.getPlayerView(db.getPlayerOffset(i)))) counts[trigram]++;
+  }
+
+  vector<uint32_t> keys;
+  for (const auto& entry: counts) keys.push_back(entry.first);
+  sort(keys.begin(), keys.end());
+  vector<uint32_t> starts(keys.size() + 1, 0);
+  unordered_map<uint32_t, uint32_t> next;
+  for (size_t k = 0; k < keys.size(); k++) {
+    next[keys[k]] = starts[k];
+    starts[k + 1] = starts[k] + counts[keys[k]];
+  }
+  vector<uint32_t> postings(starts.back());
+  for (int i = 0; i < numPlayers; i++) {
+    for (uint32_t trigram: trigramsOf(db.getPlayerView(db.getPlayerOffset(i)))) postings[next[trigram]++] = i;
+  }
+
+  trigramHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kTrigramMagic, sizeof(header.magic));
+  header.numPlayers = numPlayers;
+  header.numTrigrams = keys.size();
+  header.numPostings = postings.size();
+  header.stamp = db.getDataStamp();
+
+  // write to a temporary file and rename it into place, so that readers never see a partial index
+  const string fileName = directory + "/" + kTrigramFileName;
+  const string tempFileName = fileName + ".tmp";
+  ofstream out(tempFileName, ios::binary | ios::trunc);
+  out.write((const char *) &header, sizeof(header));
+  out.write((const char *) keys.data(), keys.size() * sizeof(uint32_t));
+  out.write((const char *) starts.data(), starts.size() * sizeof(uint32_t));
+  out.write((const char *) postings.data(), postings.size() * sizeof(uint32_t));
+  out.close();
+  if (out.fail()) {
+    unlink(tempFileName.c_str());
+    return false;
+  }
+  return rename(tempFileName.c_str(), fileName.c_str()) == 0;
+}
+
+fuzzyIndex::fuzzyIndex(const string& directory, const imdb& db) :
+  db(db), numTrigrams(0), keys(NULL), starts(NULL), postings(NULL), fd(-1), fileSize(0), fileMap(NULL) {
+  const string fileName = directory + "/" + kTrigramFileName;
+  fd = open(fileName.c_str(), O_RDONLY);
+  if (fd == -1) return;
+  struct stat stats;
+  if (fstat(fd, &stats) == -1 || stats.st_size < (off_t) sizeof(trigramHeader)) return;
+  fileSize = stats.st_size;
+  void *map = mmap(0, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+  if (map == MAP_FAILED) return;
+  fileMap = map;
+
+  const trigramHeader *header = (const trigramHeader *) fileMap;
+  size_t expectedSize = sizeof(trigramHeader) +
+    (2 * (size_t) header->numTrigrams + 1 + header->numPostings) * sizeof(uint32_t);
+  if (memcmp(header->magic, kTrigramMagic, sizeof(kTrigramMagic)) != 0 ||
+      header->numPlayers != (uint32_t) db.getNumPlayers() ||
+      header->stamp != db.getDataStamp() ||
+      fileSize != expectedSize) return;
+
+  numTrigrams = header->numTrigrams;
+  starts = (const uint32_t *) (header + 1) + numTrigrams;
+  postings = starts + numTrigrams + 1;
+  keys = (const uint32_t *) (header + 1);
+}
+
+fuzzyIndex::~fuzzyIndex() {
+  if (fileMap != NULL) munmap((void *) fileMap, fileSize);
+  if (fd != -1) close(fd);
+}
+
+vector<fuzzyIndex::match> fuzzyIndex::findPrefix(string_view prefix, size_t maxResults) const {
+  int low = 0, high = db.getNumPlayers();
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    if (db.comparePlayer(db.getPlayerOffset(mid), prefix) < 0) low = mid + 1;
+    else high = mid;
+  }
+
+  vector<match> matches;
+  for (int i = low; i < db.getNumPlayers() && matches.size() < maxResults; i++) {
+    int offset = db.getPlayerOffset(i);
+    if (db.getPlayerView(offset).substr(0, prefix.size()) != prefix) break;
+    matches.push_back(match { offset, 0 });
+  }
+  return matches;
+}
+
+vector<fuzzyIndex::match> fuzzyIndex::findSimilar(string_view name, int maxEdits, size_t maxResults) const {
+  if (!good()) return vector<match>();
+  vector<uint32_t> trigrams = trigramsOf(name);
+  int threshold = (int) trigrams.size() - 3 * maxEdits;
+
+  vector<uint32_t> candidates;
+  if (threshold <= 0) {
+    for (int i = 0; i < db.getNumPlayers(); i++) candidates.push_back(i);
+  } else {
+    // every qualifying actor appears in at least one of the (size - threshold + 1) shortest
+    // lists, so those lists supply the candidates and the longer ones are only probed
+    vector<pair<const uint32_t *, const uint32_t *>> lists;
+    for (uint32_t trigram: trigrams) {
+      const uint32_t *key = lower_bound(keys, keys + numTrigrams, trigram);
+      if (key == keys + numTrigrams || *key != trigram) {
+        lists.push_back(make_pair(postings, postings));
+      } else {
+        lists.push_back(make_pair(postings + starts[key - keys], postings + starts[key - keys + 1]));
+      }
+    }
+    sort(lists.begin(), lists.end(), [](const pair<const uint32_t *, const uint32_t *>& a,
+                                        const pair<const uint32_t *, const uint32_t *>& b) {
+      return a.second - a.first < b.second - b.first;
+    });
+
+    size_t numShortLists = lists.size() - threshold + 1;
+    vector<uint32_t> pool;
+    for (size_t l = 0; l < numShortLists; l++) pool.insert(pool.end(), lists[l].first, lists[l].second);
+    sort(pool.begin(), pool.end());
+    for (size_t i = 0; i < pool.size(); ) {
+      size_t j = i;
+      while (j < pool.size() && pool[j] == pool[i]) j++;
+      int hits = j - i;
+      for (size_t l = numShortLists; l < lists.size() && hits < threshold; l++) {
+        if (binary_search(lists[l].first, lists[l].second, pool[i])) hits++;
+      }
+      if (hits >= threshold) candidates.push_back(pool[i]);
+      i = j;
+    }
+  }
+
+  vector<pair<int, uint32_t>> scored; // (distance, actor index)
+  vector<int> previous, current;
+  for (uint32_t actor: candidates) {
+    int distance = editDistance(db.getPlayerView(db.getPlayerOffset(actor)), name, maxEdits, previous, current);
+    if (distance <= maxEdits) scored.push_back(make_pair(distance, actor));
+  }
+  sort(scored.begin(), scored.end());
+  if (scored.size() > maxResults) scored.resize(maxResults);
+
+  vector<match> matches;
+  for (const pair<int, uint32_t>& entry: scored) {
+    matches.push_back(match { db.getPlayerOffset(entry.second), entry.first });
+  }
+  return matches;
+}
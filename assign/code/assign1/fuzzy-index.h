@@ -0,0 +1,103 @@
+/**
+ * File: fuzzy-index.h
+ * -------------------
+ * Exports the fuzzyIndex class, which finds actors whose names begin with a
+ * given prefix or lie within a few typos (edits) of a given name, so that a
+ * mistyped query can be answered with suggestions instead of a dead end.
+ *
+ * Prefix lookups need nothing beyond the imdb's sorted actor table.  Fuzzy
+ * lookups rely on a trigram index built offline by build-fuzzy-index and
+ * stored in a file named "trigramindex" alongside the data files.  Every
+ * name is lowercased, padded with two blanks at the front and back, and cut
+ * into its distinct three-character substrings (trigrams); the index maps
+ * every trigram to the sorted list of actors whose names contain it.  Since
+ * a single edit destroys at most three trigrams, a name within k edits of
+ * the query must share all but 3k of the query's trigrams, and only names
+ * passing that test are ever compared against the query character by
+ * character.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "imdb.h"
+
+class fuzzyIndex {
+ public:
+
+/**
+ * Static Method: build
+ * --------------------
+ * Builds the trigram index for every actor in db and writes it to the
+ * trigramindex file in the specified directory, which should be the one db
+ * was opened on.  Returns true if and only if the file was written successfully.
+ */
+  static bool build(const imdb& db, const std::string& directory);
+
+/**
+ * Constructor: fuzzyIndex
+ * -----------------------
+ * Maps the trigramindex file in the specified directory, if there is one and
+ * it was built from exactly the data files db is backed by.  Prefix lookups
+ * work regardless, but findSimilar needs the file (see good).
+ */
+  fuzzyIndex(const std::string& directory, const imdb& db);
+  ~fuzzyIndex();
+
+/**
+ * Predicate Method: good
+ * ----------------------
+ * Returns true if and only if the trigram index was found and mapped without
+ * incident, so that findSimilar can be used.
+ */
+  bool good() const { return keys != NULL; }
+
+/**
+ * Type: match
+ * -----------
+ * One actor returned by a lookup.  offset is the actor's record offset, as
+ * understood by imdb::getPlayer, imdb::getCreditOffsets, and so forth, and
+ * distance is the number of edits separating the name from the query (always
+ * 0 for prefix matches).
+ */
+  struct match {
+    int offset;
+    int distance;
+  };
+
+/**
+ * Method: findPrefix
+ * ------------------
+ * Returns the first maxResults actors, in alphabetical order, whose names
+ * begin with the specified prefix.  Matching is case sensitive, since it's
+ * a binary search of the sorted actor table.
+ */
+  std::vector<match> findPrefix(std::string_view prefix, size_t maxResults) const;
+
+/**
+ * Method: findSimilar
+ * -------------------
+ * Returns up to maxResults actors whose names are within maxEdits insertions,
+ * deletions, or substitutions of the specified name, ignoring case, closest
+ * first (and alphabetically among equally close names).  If the name is too
+ * short for the trigram filter to rule anything out at that many edits, every
+ * actor is compared against it.  Returns nothing unless good returns true.
+ */
+  std::vector<match> findSimilar(std::string_view name, int maxEdits, size_t maxResults) const;
+
+ private:
+  const imdb& db;
+  uint32_t numTrigrams;
+  const uint32_t *keys;      // sorted trigrams
+  const uint32_t *starts;    // numTrigrams + 1 positions into postings
+  const uint32_t *postings;  // actor indices, sorted within each trigram's list
+  int fd;
+  size_t fileSize;
+  const void *fileMap;
+
+  fuzzyIndex(const fuzzyIndex& original) = delete;
+  fuzzyIndex& operator=(const fuzzyIndex& rhs) = delete;
+};
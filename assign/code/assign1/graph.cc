@@ -0,0 +1,396 @@
+/**
+ * File: graph.cc
+ * --------------
+ * Presents the implementation of the graph class.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include "graph.h"
+#include "atomic-bitmap.h"
+using namespace std;
+
+/**
+ * Function: indexOffsets
+ * ----------------------
+ * Builds the map from record byte offset to dense id, which is needed to
+ * translate the offsets embedded in credit and cast lists into ids.
+ */
+static void indexOffsets(const vector<uint32_t>& offsets, unordered_map<uint32_t, uint32_t>& ids) {
+  ids.reserve(offsets.size());
+  for (uint32_t id = 0; id < offsets.size(); id++) ids[offsets[id]] = id;
+}
+
+graph::graph(const imdb& db) : db(db) {
+  int numActors = db.getNumPlayers();
+  int numFilms = db.getNumFilms();
+  actorOffsets.resize(numActors);
+  filmOffsets.resize(numFilms);
+  for (int i = 0; i < numActors; i++) actorOffsets[i] = db.getPlayerOffset(i);
+  for (int i = 0; i < numFilms; i++) filmOffsets[i] = db.getFilmOffset(i);
+  filmYears.resize(numFilms);
+  for (int i = 0; i < numFilms; i++) filmYears[i] = db.getFilmView(filmOffsets[i]).year;
+
+  unordered_map<uint32_t, uint32_t> actorIDs, filmIDs;
+  indexOffsets(actorOffsets, actorIDs);
+  indexOffsets(filmOffsets, filmIDs);
+
+  creditStarts.reserve(numActors + 1);
+  creditStarts.push_back(0);
+  for (int i = 0; i < numActors; i++) {
+    for (int offset: db.getCreditOffsets(actorOffsets[i])) credits.push_back(filmIDs[offset]);
+    creditStarts.push_back(credits.size());
+  }
+
+  castStarts.reserve(numFilms + 1);
+  castStarts.push_back(0);
+  for (int i = 0; i < numFilms; i++) {
+    for (int offset: db.getCastOffsets(filmOffsets[i])) cast.push_back(actorIDs[offset]);
+    castStarts.push_back(cast.size());
+  }
+}
+
+// The helper types below are private to this file, and an anonymous namespace
+// keeps them from clashing with same-named types elsewhere in the program.
+namespace {
+
+/**
+ * Types: anyFilm, filmInYears
+ * ---------------------------
+ * The film filters the searches are instantiated with.  anyFilm admits
+ * everything and compiles away entirely, so unfiltered searches pay nothing
+ * for the feature.  filmInYears consults the graph's array of release years,
+ * which are stored as offsets from the base year, just as in the imdb.
+ */
+struct anyFilm {
+  bool operator()(uint32_t movie) const { return true; }
+};
+
+struct filmInYears {
+  const uint8_t *years;
+  int first, last;
+
+  filmInYears(const uint8_t *years, const yearRange& range, int baseYear) : years(years),
+    first(max(range.first, baseYear) - baseYear), last(min(range.last, baseYear + UINT8_MAX) - baseYear) {}
+  bool operator()(uint32_t movie) const { return years[movie] >= first && years[movie] <= last; }
+};
+
+/**
+ * Type: graphSearchSide
+ * ---------------------
+ * One half of a bidirectional search.  seenActors and seenFilms are the
+ * visited bitmaps.  actorParent records the film through which each
+ * visited actor was discovered, and filmParent records the actor whose
+ * expansion first reached each visited film, so that walking the two
+ * arrays alternately leads back to the root.  The parent arrays are
+ * deliberately left uninitialized, since an entry is only ever read
+ * after its visited bit has been set.
+ */
+struct graphSearchSide {
+  vector<bool> seenActors, seenFilms;
+  unique_ptr<uint32_t[]> actorParent, filmParent;
+  vector<uint32_t> frontier;
+  int depth;
+
+  graphSearchSide(const graph& g, uint32_t root) :
+    seenActors(g.getNumActors()), seenFilms(g.getNumFilms()),
+    actorParent(new uint32_t[g.getNumActors()]), filmParent(new uint32_t[g.getNumFilms()]),
+    frontier(1, root), depth(0) {
+    seenActors[root] = true;
+  }
+};
+
+}
+
+/**
+ * Function: expandLevel
+ * ---------------------
+ * Expands every actor in side's frontier by one hop through the films accept
+ * admits, returning true and surfacing the actor via meet the moment an actor
+ * already seen by the other side is reached.
+ */
+template <typename Filter>
+static bool expandLevel(const graph& g, graphSearchSide& side, const graphSearchSide& other,
+                        const Filter& accept, uint32_t& meet) {
+  vector<uint32_t> next;
+  for (uint32_t actor: side.frontier) {
+    auto credits = g.getCredits(actor);
+    for (const uint32_t *f = credits.first; f != credits.second; f++) {
+      if (side.seenFilms[*f] || !accept(*f)) continue;
+      side.seenFilms[*f] = true;
+      side.filmParent[*f] = actor;
+      auto cast = g.getCast(*f);
+      for (const uint32_t *p = cast.first; p != cast.second; p++) {
+        if (side.seenActors[*p]) continue;
+        side.seenActors[*p] = true;
+        side.actorParent[*p] = *f;
+        if (other.seenActors[*p]) {
+          meet = *p;
+          return true;
+        }
+        next.push_back(*p);
+      }
+    }
+  }
+
+  side.frontier.swap(next);
+  side.depth++;
+  return false;
+}
+
+/**
+ * Function: buildLinks
+ * --------------------
+ * Walks the parent arrays of both sides of a bidirectional search outward from
+ * the actor where they met, producing the (film, actor) links that lead from
+ * source to target.  Works with any side type exposing actorParent and filmParent.
+ */
+template <typename Side>
+static void buildLinks(const Side& fromSource, const Side& fromTarget, uint32_t source, uint32_t target,
+                       uint32_t meet, vector<pair<uint32_t, uint32_t>>& links) {
+  list<pair<uint32_t, uint32_t>> chain;
+  for (uint32_t actor = meet; actor != source; actor = fromSource.filmParent[fromSource.actorParent[actor]])
+    chain.push_front({fromSource.actorParent[actor], actor});
+  for (uint32_t actor = meet; actor != target; actor = fromTarget.filmParent[fromTarget.actorParent[actor]])
+    chain.push_back({fromTarget.actorParent[actor], fromTarget.filmParent[fromTarget.actorParent[actor]]});
+  links.assign(chain.begin(), chain.end());
+}
+
+/**
+ * Function: searchGraph
+ * ---------------------
+ * The body of findShortestPath, instantiated once per kind of film filter.
+ */
+template <typename Filter>
+static bool searchGraph(const graph& g, uint32_t source, uint32_t target, int maxHops,
+                        const Filter& accept, vector<pair<uint32_t, uint32_t>>& links) {
+  if (source == target) return false;
+  graphSearchSide fromSource(g, source), fromTarget(g, target);
+  uint32_t meet;
+  bool found = false;
+  while (!found && fromSource.depth + fromTarget.depth < maxHops &&
+         !fromSource.frontier.empty() && !fromTarget.frontier.empty()) {
+    if (fromSource.frontier.size() <= fromTarget.frontier.size()) {
+      found = expandLevel(g, fromSource, fromTarget, accept, meet);
+    } else {
+      found = expandLevel(g, fromTarget, fromSource, accept, meet);
+    }
+  }
+
+  if (!found) return false;
+
+  buildLinks(fromSource, fromTarget, source, target, meet, links);
+  return true;
+}
+
+bool graph::findShortestPath(uint32_t source, uint32_t target, int maxHops,
+                             vector<pair<uint32_t, uint32_t>>& links, const yearRange& years) const {
+  if (years.includesAll()) return searchGraph(*this, source, target, maxHops, anyFilm(), links);
+  return searchGraph(*this, source, target, maxHops, filmInYears(filmYears.data(), years, kBaseYear), links);
+}
+
+void graph::computeDistances(uint32_t source, vector<uint8_t>& distances) const {
+  distances.assign(getNumActors(), kUnreachableDistance);
+  vector<bool> seenFilms(getNumFilms());
+  vector<uint32_t> frontier(1, source), next;
+  distances[source] = 0;
+  for (int depth = 1; !frontier.empty() && depth < kUnreachableDistance; depth++) {
+    next.clear();
+    for (uint32_t actor: frontier) {
+      auto credits = getCredits(actor);
+      for (const uint32_t *f = credits.first; f != credits.second; f++) {
+        if (seenFilms[*f]) continue;
+        seenFilms[*f] = true;
+        auto cast = getCast(*f);
+        for (const uint32_t *p = cast.first; p != cast.second; p++) {
+          if (distances[*p] != kUnreachableDistance) continue;
+          distances[*p] = depth;
+          next.push_back(*p);
+        }
+      }
+    }
+    frontier.swap(next);
+  }
+}
+
+namespace {
+
+/**
+ * Type: parallelSearchSide
+ * ------------------------
+ * Same as graphSearchSide, except that the visited sets are atomicBitmaps
+ * so that several threads can expand the same frontier at once.  Each parent
+ * entry is written only by the thread that won the race to set the
+ * corresponding visited bit.
+ */
+struct parallelSearchSide {
+  atomicBitmap seenActors, seenFilms;
+  unique_ptr<uint32_t[]> actorParent, filmParent;
+  vector<uint32_t> frontier;
+  int depth;
+
+  parallelSearchSide(const graph& g, uint32_t root) :
+    seenActors(g.getNumActors()), seenFilms(g.getNumFilms()),
+    actorParent(new uint32_t[g.getNumActors()]), filmParent(new uint32_t[g.getNumFilms()]),
+    frontier(1, root), depth(0) {
+    seenActors.testAndSet(root);
+  }
+};
+
+}
+
+/**
+ * Constant: kFrontierChunkSize
+ * ----------------------------
+ * The number of frontier actors a worker claims at a time.  Small enough to
+ * balance the load when a few actors have enormous filmographies, large enough
+ * that workers rarely contend on the shared counter.
+ */
+static const size_t kFrontierChunkSize = 64;
+
+/**
+ * Constant: kNoActor
+ * ------------------
+ * Placeholder for a worker that didn't find the meeting point.
+ */
+static const uint32_t kNoActor = UINT32_MAX;
+
+/**
+ * Function: expandLevelInParallel
+ * -------------------------------
+ * Parallel version of expandLevel.  numThreads workers repeatedly claim the
+ * next chunk of the frontier and expand it, collecting newly discovered actors
+ * in per-thread vectors that are concatenated once every worker is done.  The
+ * other side is never modified while a level is being expanded, so its visited
+ * bitmap can be consulted without any synchronization beyond the atomics.  When
+ * any worker discovers an actor the other side has already seen, all workers
+ * stop at their next opportunity.  Only films accept admits are expanded.
+ */
+template <typename Filter>
+static bool expandLevelInParallel(const graph& g, parallelSearchSide& side, const parallelSearchSide& other,
+                                  size_t numThreads, const Filter& accept, uint32_t& meet) {
+  atomic<size_t> nextChunk(0);
+  atomic<bool> found(false);
+  vector<vector<uint32_t>> discovered(numThreads);
+  vector<uint32_t> meets(numThreads, kNoActor);
+  vector<thread> workers;
+  for (size_t id = 0; id < numThreads; id++) {
+    workers.push_back(thread([&](size_t id) {
+      while (!found) {
+        size_t start = nextChunk.fetch_add(kFrontierChunkSize);
+        if (start >= side.frontier.size()) return;
+        size_t end = min(start + kFrontierChunkSize, side.frontier.size());
+        for (size_t i = start; i < end; i++) {
+          uint32_t actor = side.frontier[i];
+          auto credits = g.getCredits(actor);
+          for (const uint32_t *f = credits.first; f != credits.second; f++) {
+            if (!accept(*f) || side.seenFilms.testAndSet(*f)) continue;
+            side.filmParent[*f] = actor;
+            auto cast = g.getCast(*f);
+            for (const uint32_t *p = cast.first; p != cast.second; p++) {
+              if (side.seenActors.testAndSet(*p)) continue;
+              side.actorParent[*p] = *f;
+              if (other.seenActors.test(*p)) {
+                meets[id] = *p;
+                found = true;
+                return;
+              }
+              discovered[id].push_back(*p);
+            }
+          }
+        }
+      }
+    }, id));
+  }
+  for (thread& t: workers) t.join();
+
+  for (uint32_t actor: meets) {
+    if (actor != kNoActor) {
+      meet = actor;
+      return true;
+    }
+  }
+
+  side.frontier.clear();
+  for (const vector<uint32_t>& actors: discovered)
+    side.frontier.insert(side.frontier.end(), actors.begin(), actors.end());
+  side.depth++;
+  return false;
+}
+
+/**
+ * Function: searchGraphInParallel
+ * -------------------------------
+ * The body of findShortestPathInParallel, instantiated once per kind of film filter.
+ */
+template <typename Filter>
+static bool searchGraphInParallel(const graph& g, uint32_t source, uint32_t target, int maxHops,
+                                  size_t numThreads, const Filter& accept,
+                                  vector<pair<uint32_t, uint32_t>>& links) {
+  if (source == target) return false;
+  parallelSearchSide fromSource(g, source), fromTarget(g, target);
+  uint32_t meet;
+  bool found = false;
+  while (!found && fromSource.depth + fromTarget.depth < maxHops &&
+         !fromSource.frontier.empty() && !fromTarget.frontier.empty()) {
+    if (fromSource.frontier.size() <= fromTarget.frontier.size()) {
+      found = expandLevelInParallel(g, fromSource, fromTarget, numThreads, accept, meet);
+    } else {
+      found = expandLevelInParallel(g, fromTarget, fromSource, numThreads, accept, meet);
+    }
+  }
+
+  if (!found) return false;
+  buildLinks(fromSource, fromTarget, source, target, meet, links);
+  return true;
+}
+
+bool graph::findShortestPathInParallel(uint32_t source, uint32_t target, int maxHops, size_t numThreads,
+                                       vector<pair<uint32_t, uint32_t>>& links, const yearRange& years) const {
+  if (years.includesAll()) return searchGraphInParallel(*this, source, target, maxHops, numThreads, anyFilm(), links);
+  return searchGraphInParallel(*this, source, target, maxHops, numThreads,
+                               filmInYears(filmYears.data(), years, kBaseYear), links);
+}
+
+void graph::computeDistancesInParallel(uint32_t source, size_t numThreads, vector<uint8_t>& distances) const {
+  distances.assign(getNumActors(), kUnreachableDistance);
+  atomicBitmap seenActors(getNumActors()), seenFilms(getNumFilms());
+  seenActors.testAndSet(source);
+  distances[source] = 0;
+  vector<uint32_t> frontier(1, source);
+  for (int depth = 1; !frontier.empty() && depth < kUnreachableDistance; depth++) {
+    atomic<size_t> nextChunk(0);
+    vector<vector<uint32_t>> discovered(numThreads);
+    vector<thread> workers;
+    for (size_t id = 0; id < numThreads; id++) {
+      workers.push_back(thread([&](size_t id) {
+        while (true) {
+          size_t start = nextChunk.fetch_add(kFrontierChunkSize);
+          if (start >= frontier.size()) return;
+          size_t end = min(start + kFrontierChunkSize, frontier.size());
+          for (size_t i = start; i < end; i++) {
+            auto credits = getCredits(frontier[i]);
+            for (const uint32_t *f = credits.first; f != credits.second; f++) {
+              if (seenFilms.testAndSet(*f)) continue;
+              auto cast = getCast(*f);
+              for (const uint32_t *p = cast.first; p != cast.second; p++) {
+                if (seenActors.testAndSet(*p)) continue;
+                distances[*p] = depth; // only the thread that claimed *p writes this entry
+                discovered[id].push_back(*p);
+              }
+            }
+          }
+        }
+      }, id));
+    }
+    for (thread& t: workers) t.join();
+
+    frontier.clear();
+    for (const vector<uint32_t>& actors: discovered)
+      frontier.insert(frontier.end(), actors.begin(), actors.end());
+  }
+}
@@ -0,0 +1,176 @@
+/**
+ * File: graph.h
+ * -------------
+ * Exports the graph class, which is a compact, integer-indexed view of
+ * the bipartite actor/movie graph stored in an imdb's data files.
+ *
+ * Actors are identified by their index into the imdb's sorted actor table
+ * and films by their index into the sorted movie table, so both are dense
+ * integers starting at 0.  The adjacency lists of both halves of the graph
+ * are stored in compressed-sparse-row form: all credits (film ids) for all
+ * actors are laid out back to back in one array, and a second array of
+ * getNumActors() + 1 start positions records where each actor's credits
+ * begin.  Casts (actor ids) are stored the same way.  Nothing is turned into
+ * a string until a client asks for a name via getPlayer or getFilm.
+ */
+
+#pragma once
+#include <climits>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "imdb.h"
+
+/**
+ * Constant: kUnreachableDistance
+ * ------------------------------
+ * The distance computeDistances assigns to actors it can't reach.  Distances
+ * are stored in a byte apiece, so anything at or beyond it is treated the same way.
+ */
+static const uint8_t kUnreachableDistance = 255;
+
+/**
+ * Type: yearRange
+ * ---------------
+ * An inclusive range of release years (1980, not 80), used to restrict a
+ * search to the films released within it.  kAllYears admits every film.
+ */
+struct yearRange {
+  int first;
+  int last;
+
+  bool includesAll() const { return first == INT_MIN && last == INT_MAX; }
+};
+
+static const yearRange kAllYears = { INT_MIN, INT_MAX };
+
+class graph {
+ public:
+
+/**
+ * Constructor: graph
+ * ------------------
+ * Walks every actor and movie record of the specified imdb once to build the
+ * compressed adjacency lists.  The imdb must outlive the graph, since names
+ * are pulled from it on demand.
+ */
+  graph(const imdb& db);
+
+/**
+ * Methods: getNumActors, getNumFilms
+ * ----------------------------------
+ * Self-explanatory.
+ */
+  uint32_t getNumActors() const { return actorOffsets.size(); }
+  uint32_t getNumFilms() const { return filmOffsets.size(); }
+
+/**
+ * Methods: getCredits, getCast
+ * ----------------------------
+ * Return the [begin, end) range of film ids the specified actor appeared
+ * in, or of actor ids appearing in the specified film.
+ */
+  std::pair<const uint32_t *, const uint32_t *> getCredits(uint32_t actor) const {
+    return std::make_pair(credits.data() + creditStarts[actor], credits.data() + creditStarts[actor + 1]);
+  }
+
+  std::pair<const uint32_t *, const uint32_t *> getCast(uint32_t movie) const {
+    return std::make_pair(cast.data() + castStarts[movie], cast.data() + castStarts[movie + 1]);
+  }
+
+/**
+ * Methods: findActor, getPlayer, getFilm
+ * --------------------------------------
+ * findActor maps a name to an actor id, returning -1 if the actor/actress
+ * doesn't exist.  getPlayer and getFilm go the other way, materializing
+ * names only when they're actually needed.
+ */
+  int findActor(const std::string& player) const { return db.findPlayer(player); }
+  const std::string getPlayer(uint32_t actor) const { return db.getPlayer(actorOffsets[actor]); }
+  const film getFilm(uint32_t movie) const { return db.getFilm(filmOffsets[movie]); }
+
+/**
+ * Method: getYear
+ * ---------------
+ * Returns the release year of the specified film (1980, not 80), read from
+ * an array of years built alongside the adjacency lists so that filtering
+ * films by year never touches the imdb.
+ */
+  int getYear(uint32_t movie) const { return kBaseYear + filmYears[movie]; }
+
+/**
+ * Method: findShortestPath
+ * ------------------------
+ * Runs a bidirectional breadth-first search between the two actor ids,
+ * always expanding the smaller of the two frontiers by a full level.
+ * Visits are tracked in bitmaps indexed by id, so the search allocates
+ * just a handful of arrays no matter how much of the graph it touches.
+ * If a year range other than kAllYears is supplied, films released outside
+ * of it are skipped as the frontiers expand, so the path found is the
+ * shortest one using only films from within the range.
+ *
+ * @param source the id of the actor the path should start from.
+ * @param target the id of the actor the path should end at.
+ * @param maxHops the longest chain of films worth considering.
+ * @param links populated with the (film id, actor id) pairs leading from
+ *              source to target, in order.  Left empty if no path exists.
+ * @param years the release years of the films the path may use.
+ * @return true if and only if a path of at most maxHops films was found.
+ */
+  bool findShortestPath(uint32_t source, uint32_t target, int maxHops,
+                        std::vector<std::pair<uint32_t, uint32_t>>& links,
+                        const yearRange& years = kAllYears) const;
+
+/**
+ * Method: findShortestPathInParallel
+ * ----------------------------------
+ * Multithreaded version of findShortestPath.  The search is still level
+ * synchronous and still expands the smaller frontier, but each level is
+ * split across numThreads worker threads, which pull chunks of the frontier
+ * from a shared counter and claim actors and films via atomic visited
+ * bitmaps.  The path found is always as short as the one findShortestPath
+ * finds, although when several shortest paths exist, the two may surface
+ * different ones.  Parameters and return value are otherwise the same.
+ */
+  bool findShortestPathInParallel(uint32_t source, uint32_t target, int maxHops, size_t numThreads,
+                                  std::vector<std::pair<uint32_t, uint32_t>>& links,
+                                  const yearRange& years = kAllYears) const;
+
+/**
+ * Method: computeDistances
+ * ------------------------
+ * Runs an unbounded breadth-first search from source over the entire graph and
+ * sets distances[a] to the number of films separating source from actor a, or to
+ * kUnreachableDistance if there's no connection at all.  distances is resized to
+ * getNumActors() entries.
+ */
+  void computeDistances(uint32_t source, std::vector<uint8_t>& distances) const;
+
+/**
+ * Method: computeDistancesInParallel
+ * ----------------------------------
+ * Multithreaded version of computeDistances, for when the distances from
+ * one actor to everyone else are wanted right away rather than as one job of
+ * many.  Each level of the search is split across numThreads worker threads
+ * the same way findShortestPathInParallel splits its levels, and the visited
+ * sets are atomic bitmaps (one bit per film, one per actor).  The distances
+ * computed are identical to those computeDistances computes.
+ */
+  void computeDistancesInParallel(uint32_t source, size_t numThreads, std::vector<uint8_t>& distances) const;
+
+ private:
+  const imdb& db;
+  std::vector<uint32_t> actorOffsets;  // actor id -> byte offset of the actor record
+  std::vector<uint32_t> filmOffsets;   // film id -> byte offset of the movie record
+  std::vector<uint32_t> creditStarts;  // actor id -> index of first credit
+  std::vector<uint32_t> credits;       // film ids
+  std::vector<uint32_t> castStarts;    // film id -> index of first cast member
+  std::vector<uint32_t> cast;          // actor ids
+  std::vector<uint8_t> filmYears;      // film id -> release year - kBaseYear, as stored in the imdb
+
+  static const int kBaseYear = 1900;
+
+  graph(const graph& original) = delete;
+  graph& operator=(const graph& rhs) = delete;
+};
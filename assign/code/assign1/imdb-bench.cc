@@ -0,0 +1,228 @@
+/**
+ * File: imdb-bench.cc
+ * -------------------
+ * Query-latency benchmark for the imdb and the search engines built on it.
+ * The database is loaded once, and then three batches of randomized queries
+ * are timed one query at a time: getCredits on random actors, getCast on
+ * random films, and full searches between random pairs of actors.
+ *
+ * Every batch (and the initial load) is reported as one line of JSON on
+ * standard output, so runs can be collected and compared mechanically:
+ *
+ *     {"benchmark": "getCredits", "queries": 10000, "seconds": 0.0123,
+ *      "queries_per_second": 813008, "p50_us": 1.1, "p99_us": 3.9, "p999_us": 12.4,
+ *      "allocations": 30512, "allocated_bytes": 1236480, "minor_faults": 3,
+ *      "major_faults": 0}
+ *
+ * (shown wrapped here, but always printed on a single line).  Allocation counts
+ * come from replacing the global operator new, and page-fault counts are the
+ * getrusage deltas across the batch.  The same seed always yields the same
+ * queries, so runs against different builds are directly comparable.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include "imdb.h"
+#include "graph.h"
+#include "path.h"
+#include "search-engines.h"
+
+using namespace std;
+
+static const int kDatabaseNotFound = 2;
+static const int kUnrecognizedFlag = 3;
+
+static const string kQueriesFlag = "--queries=";
+static const string kSearchesFlag = "--searches=";
+static const string kSeedFlag = "--seed=";
+static const string kEngineFlag = "--engine=";
+static const string kForwardEngine = "forward";
+static const string kBidirectionalEngine = "bidirectional";
+static const string kGraphEngine = "graph";
+static const int kDefaultNumQueries = 10000;
+static const int kDefaultNumSearches = 200;
+static const unsigned int kDefaultSeed = 110;
+
+/**
+ * Allocation counting
+ * -------------------
+ * Every allocation in the process goes through these replacements, which just
+ * bump two counters before deferring to malloc.
+ */
+static atomic<size_t> numAllocations(0);
+static atomic<size_t> numAllocatedBytes(0);
+
+void *operator new(size_t size) {
+  numAllocations++;
+  numAllocatedBytes += size;
+  void *memory = malloc(size == 0 ? 1 : size);
+  if (memory == NULL) throw bad_alloc();
+  return memory;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *memory) noexcept { free(memory); }
+void operator delete[](void *memory) noexcept { free(memory); }
+void operator delete(void *memory, size_t) noexcept { free(memory); }
+void operator delete[](void *memory, size_t) noexcept { free(memory); }
+
+/**
+ * Type: counters
+ * --------------
+ * A snapshot of everything a benchmark reports the change in.
+ */
+struct counters {
+  chrono::steady_clock::time_point when;
+  size_t allocations;
+  size_t allocatedBytes;
+  long minorFaults;
+  long majorFaults;
+
+  static counters now() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return counters { chrono::steady_clock::now(), numAllocations, numAllocatedBytes,
+                      usage.ru_minflt, usage.ru_majflt };
+  }
+};
+
+/**
+ * Function: percentile
+ * --------------------
+ * Returns the pth percentile (0 < p <= 1) of the sorted latencies, using the
+ * nearest-rank definition.
+ */
+static double percentile(const vector<double>& sorted, double p) {
+  if (sorted.empty()) return 0;
+  size_t rank = (size_t) ceil(p * sorted.size());
+  return sorted[max(rank, (size_t) 1) - 1];
+}
+
+/**
+ * Function: report
+ * ----------------
+ * Prints one benchmark's JSON line.  latencies are in microseconds and are
+ * sorted in place.
+ */
+static void report(const string& name, vector<double>& latencies, const counters& before, const counters& after) {
+  sort(latencies.begin(), latencies.end());
+  double seconds = chrono::duration<double>(after.when - before.when).count();
+  cout << "{\"benchmark\": \"" << name << "\", \"queries\": " << latencies.size()
+       << ", \"seconds\": " << seconds
+       << ", \"queries_per_second\": " << (seconds > 0 ? latencies.size() / seconds : 0)
+       << ", \"p50_us\": " << percentile(latencies, 0.5)
+       << ", \"p99_us\": " << percentile(latencies, 0.99)
+       << ", \"p999_us\": " << percentile(latencies, 0.999)
+       << ", \"allocations\": " << after.allocations - before.allocations
+       << ", \"allocated_bytes\": " << after.allocatedBytes - before.allocatedBytes
+       << ", \"minor_faults\": " << after.minorFaults - before.minorFaults
+       << ", \"major_faults\": " << after.majorFaults - before.majorFaults << "}" << endl;
+}
+
+/**
+ * Function: runBenchmark
+ * ----------------------
+ * Times query(q) for every q in queries, one at a time, and reports the results.
+ */
+template <typename Query, typename Runner>
+static void runBenchmark(const string& name, const vector<Query>& queries, Runner query) {
+  vector<double> latencies;
+  latencies.reserve(queries.size());
+  counters before = counters::now();
+  for (const Query& q: queries) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    query(q);
+    latencies.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+  }
+  counters after = counters::now();
+  report(name, latencies, before, after);
+}
+
+/**
+ * Function: processCommandLineFlags
+ * ---------------------------------
+ * Parses every argument as a flag, returning false if any isn't recognized.
+ */
+static bool processCommandLineFlags(int argc, char *argv[], int& numQueries, int& numSearches,
+                                    unsigned int& seed, string& engine) {
+  for (int i = 1; i < argc; i++) {
+    const string flag = argv[i];
+    if (flag.compare(0, kQueriesFlag.size(), kQueriesFlag) == 0 && atoi(argv[i] + kQueriesFlag.size()) > 0) {
+      numQueries = atoi(argv[i] + kQueriesFlag.size());
+    } else if (flag.compare(0, kSearchesFlag.size(), kSearchesFlag) == 0 && atoi(argv[i] + kSearchesFlag.size()) >= 0) {
+      numSearches = atoi(argv[i] + kSearchesFlag.size());
+    } else if (flag.compare(0, kSeedFlag.size(), kSeedFlag) == 0) {
+      seed = strtoul(argv[i] + kSeedFlag.size(), NULL, 10);
+    } else if (flag.compare(0, kEngineFlag.size(), kEngineFlag) == 0) {
+      engine = flag.substr(kEngineFlag.size());
+      if (engine != kForwardEngine && engine != kBidirectionalEngine && engine != kGraphEngine) return false;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  int numQueries = kDefaultNumQueries, numSearches = kDefaultNumSearches;
+  unsigned int seed = kDefaultSeed;
+  string engine = kGraphEngine;
+  if (!processCommandLineFlags(argc, argv, numQueries, numSearches, seed, engine)) {
+    cerr << "Usage: " << argv[0] << " [" << kQueriesFlag << "<n>] [" << kSearchesFlag << "<n>] ["
+         << kSeedFlag << "<n>] [" << kEngineFlag << kForwardEngine << "|" << kBidirectionalEngine
+         << "|" << kGraphEngine << "]" << endl;
+    return kUnrecognizedFlag;
+  }
+
+  counters before = counters::now();
+  imdb db(kIMDBDataDirectory);
+  if (!db.good()) {
+    cerr << "Data directory not found!  Aborting..." << endl;
+    return kDatabaseNotFound;
+  }
+  unique_ptr<graph> g;
+  if (engine == kGraphEngine) g.reset(new graph(db));
+  counters after = counters::now();
+  vector<double> loadLatency(1, chrono::duration<double, micro>(after.when - before.when).count());
+  report("load", loadLatency, before, after);
+
+  // materialize every query up front so that building them isn't measured
+  mt19937 generator(seed);
+  uniform_int_distribution<int> randomPlayer(0, db.getNumPlayers() - 1);
+  uniform_int_distribution<int> randomFilm(0, db.getNumFilms() - 1);
+  vector<string> players;
+  vector<film> films;
+  vector<pair<string, string>> pairs;
+  for (int i = 0; i < numQueries; i++) players.push_back(db.getPlayer(db.getPlayerOffset(randomPlayer(generator))));
+  for (int i = 0; i < numQueries; i++) films.push_back(db.getFilm(db.getFilmOffset(randomFilm(generator))));
+  for (int i = 0; i < numSearches; i++) {
+    pairs.push_back(make_pair(db.getPlayer(db.getPlayerOffset(randomPlayer(generator))),
+                              db.getPlayer(db.getPlayerOffset(randomPlayer(generator)))));
+  }
+
+  runBenchmark("getCredits", players, [&db](const string& player) {
+    vector<film> credits;
+    db.getCredits(player, credits);
+  });
+  runBenchmark("getCast", films, [&db](const film& movie) {
+    vector<string> cast;
+    db.getCast(movie, cast);
+  });
+  runBenchmark("search-" + engine, pairs, [&db, &g, &engine](const pair<string, string>& query) {
+    path result(query.first);
+    if (engine == kForwardEngine) forwardSearch(db, query.first, query.second, result);
+    else if (engine == kBidirectionalEngine) bidirectionalSearch(db, query.first, query.second, result);
+    else graphSearch(*g, query.first, query.second, result);
+  });
+  return 0;
+}
@@ -1,10 +1,32 @@
 #pragma once
+#include <cstdint>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <iostream>
 
 const std::string kIMDBDataDirectory("./slink/");
 
+/**
+ * Convenience struct: dataStamp
+ * -----------------------------
+ * Identifies the data files an imdb is backed by, so that an index built from
+ * them (the name, trigram, and landmark indices) can tell when it's stale:
+ * the sizes of actordata and moviedata, or the size of compactdata, with the
+ * sizes of whichever files aren't in use set to 0.
+ */
+struct dataStamp {
+  uint64_t actorFileSize;
+  uint64_t movieFileSize;
+  uint64_t compactFileSize;
+
+  bool operator==(const dataStamp& rhs) const {
+    return actorFileSize == rhs.actorFileSize && movieFileSize == rhs.movieFileSize &&
+      compactFileSize == rhs.compactFileSize;
+  }
+  bool operator!=(const dataStamp& rhs) const { return !(*this == rhs); }
+};
+
 /**
  * Convenience struct: film
  * ------------------------
@@ -46,3 +68,34 @@ struct film {
   }
 };
 
+/**
+ * Convenience struct: filmView
+ * ----------------------------
+ * The zero-copy counterpart of film.  The title is a std::string_view, which
+ * typically points straight into an imdb's memory-mapped movie file, so
+ * filmViews are cheap to create and copy, but they're only valid for as long
+ * as the imdb they came from.  A filmView can be built from a film (in which
+ * case it views that film's title), compared against other filmViews
+ * using the same ordering as film, and turned back into a film via toFilm.
+ */
+struct filmView {
+
+  std::string_view title;
+  int year;
+
+  filmView() : year(0) {}
+  filmView(std::string_view title, int year) : title(title), year(year) {}
+  filmView(const film& movie) : title(movie.title), year(movie.year) {}
+
+  film toFilm() const { return film { std::string(title), year }; }
+
+  bool operator==(const filmView& rhs) const {
+    return this->title == rhs.title && (this->year == rhs.year);
+  }
+
+  bool operator<(const filmView& rhs) const {
+    return
+      (this->title < rhs.title) ||
+      (this->title == rhs.title && this->year < rhs.year);
+  }
+};
@@ -2,6 +2,10 @@
 #include <sys/stat.h>
 #include <sys/mman.h>
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
 #include <fcntl.h>
 #include <unistd.h>
 #include "imdb.h"
@@ -9,73 +13,230 @@ using namespace std;
 
 const char *const imdb::kActorFileName = "actordata";
 const char *const imdb::kMovieFileName = "moviedata";
-imdb::imdb(const string& directory) {
-    const string actorFileName = directory + "/" + kActorFileName;
-    const string movieFileName = directory + "/" + kMovieFileName;
-    actorFile = acquireFileMap(actorFileName, actorInfo);
-    movieFile = acquireFileMap(movieFileName, movieInfo);
+const char *const imdb::kCompactFileName = "compactdata";
+
+/**
+ * The compact data file is laid out as follows, with each section starting
+ * at the offset recorded for it in the header:
+ *
+ *     header:      magic string, record counts, and section offsets
+ *     stringPool:  every distinct name and title, null-terminated
+ *     playerTable: (name, credits) offset pairs, one per actor, in sorted order
+ *     filmTable:   (title, cast) offset pairs, one per movie, in sorted order
+ *     filmYears:   one byte per movie, encoded the same way as film::year
+ *     creditLists: per actor, a varint count followed by that many varints,
+ *                  each a zigzag-encoded difference between consecutive film indices
+ *     castLists:   per movie, the same thing, but listing actor indices
+ */
+static const char kCompactMagic[8] = {'I', 'M', 'D', 'B', 'C', 'M', 'P', '1'};
+
+struct compactHeader {
+    char magic[8];
+    uint32_t numPlayers;
+    uint32_t numFilms;
+    uint64_t stringPoolStart;
+    uint64_t playerTableStart;
+    uint64_t filmTableStart;
+    uint64_t filmYearsStart;
+    uint64_t creditListsStart;
+    uint64_t castListsStart;
+};
+
+imdb::imdb(const string& directory) :
+    actorFile(NULL), movieFile(NULL), stringPool(NULL), playerTable(NULL), filmTable(NULL),
+    filmYears(NULL), creditLists(NULL), castLists(NULL), numCompactPlayers(0), numCompactFilms(0) {
+    actorInfo = movieInfo = compactInfo = fileInfo { -1, 0, NULL };
+    const string compactFileName = directory + "/" + kCompactFileName;
+    if (access(compactFileName.c_str(), F_OK) == 0) {
+        openCompact(compactFileName);
+    } else {
+        const string actorFileName = directory + "/" + kActorFileName;
+        const string movieFileName = directory + "/" + kMovieFileName;
+        actorFile = acquireFileMap(actorFileName, actorInfo);
+        movieFile = acquireFileMap(movieFileName, movieInfo);
+    }
+    if (good()) names.open(directory, getNumPlayers(), getNumFilms(), getDataStamp());
 }
 
 bool imdb::good() const {
+    if (isCompact()) return true;
     return !( (actorInfo.fd == -1) || (movieInfo.fd == -1) );
 }
 
 imdb::~imdb() {
     releaseFileMap(actorInfo);
     releaseFileMap(movieInfo);
+    releaseFileMap(compactInfo);
 }
 
-bool imdb::getCredits(const string& player, vector<film>& films) const {
-    const int numPlayers = *(int *) actorFile;
-    int *firstOffset = (int *) actorFile + 1;
-    int *lastOffset = (int *) actorFile + numPlayers;
-    const int *playerOffset = lower_bound(firstOffset, lastOffset, player, [&](const int a, const string& b) -> bool {
-        return getPlayer(a).compare(b) < 0;
-    });
-    if (getPlayer(*playerOffset) != player) return false;
+/**
+ * Method: openCompact
+ * -------------------
+ * Maps the compact data file and, provided its header is intact and every
+ * section lies within the file, points the section pointers into it.
+ * Otherwise the section pointers are left null, so good returns false.
+ */
+bool imdb::openCompact(const string& fileName) {
+    const void *map = acquireFileMap(fileName, compactInfo);
+    if (compactInfo.fd == -1 || map == MAP_FAILED || compactInfo.fileSize < sizeof(compactHeader)) return false;
 
-    // Skip name
-    char *player_ptr = (char *) actorFile + *playerOffset;
-    long nameSpaceUsed = (player.length() % 2 == 0) ? player.length() + 2 : player.length() + 1;
-    player_ptr += nameSpaceUsed;
+    const compactHeader *header = (const compactHeader *) map;
+    if (memcmp(header->magic, kCompactMagic, sizeof(kCompactMagic)) != 0 ||
+        header->stringPoolStart < sizeof(compactHeader) ||
+        header->playerTableStart < header->stringPoolStart ||
+        header->playerTableStart % sizeof(uint32_t) != 0 || header->filmTableStart % sizeof(uint32_t) != 0 ||
+        header->filmTableStart < header->playerTableStart + 2 * sizeof(uint32_t) * (uint64_t) header->numPlayers ||
+        header->filmYearsStart < header->filmTableStart + 2 * sizeof(uint32_t) * (uint64_t) header->numFilms ||
+        header->creditListsStart < header->filmYearsStart + header->numFilms ||
+        header->castListsStart < header->creditListsStart ||
+        header->castListsStart > compactInfo.fileSize) return false;
 
-    // Skip number of movies
-    short numMovies = *(short *) player_ptr;
-    player_ptr += ((nameSpaceUsed + 2) % 4 == 0) ? 2 : 4;
+    const char *base = (const char *) map;
+    if (header->playerTableStart > header->stringPoolStart && base[header->playerTableStart - 1] != '\0')
+        return false; // the last string must be terminated
+    numCompactPlayers = header->numPlayers;
+    numCompactFilms = header->numFilms;
+    playerTable = (const uint32_t *) (base + header->playerTableStart);
+    filmTable = (const uint32_t *) (base + header->filmTableStart);
+    filmYears = base + header->filmYearsStart;
+    creditLists = (const unsigned char *) base + header->creditListsStart;
+    castLists = (const unsigned char *) base + header->castListsStart;
+    stringPool = base + header->stringPoolStart;
+    return true;
+}
 
-    // Store all movies into vector
-    for (short i=0; i < numMovies; i++) {
-        films.push_back(getFilm(*(int *) player_ptr));
-        player_ptr += 4;
+bool imdb::getCredits(const string& player, vector<film>& films) const {
+    int index = findPlayer(player);
+    if (index < 0) return false;
+
+    for (int movieOffset: getCreditOffsets(getPlayerOffset(index))) {
+        films.push_back(getFilm(movieOffset));
     }
 
     return true;
 }
 
 const string imdb::getPlayer(int offset) const {
-    return string((char *) actorFile + offset);
+    return string(getPlayerView(offset));
 }
 
 const film imdb::getFilm(int offset) const {
-    char *film_ptr = (char *) movieFile + offset;
-    const string filmName = string(film_ptr);
-    film_ptr += filmName.length() + 1;
-    char year = *film_ptr;
-    return film { filmName, year };
+    return getFilmView(offset).toFilm();
 }
 
 bool imdb::getCast(const film& movie, vector<string>& players) const {
-    const int numFilms = *(int *) movieFile;
-    int *firstOffset = (int *) movieFile + 1;
-    int *lastOffset = (int *) movieFile + numFilms;
-    const int *movieOffset = lower_bound(firstOffset, lastOffset, movie, [&](const int a, const film& b) -> bool {
-        return getFilm(a) < b;
-    });
-    if (!(getFilm(*movieOffset) == movie)) return false;
+    int index = findFilm(movie);
+    if (index < 0) return false;
+
+    for (int actorOffset: getCastOffsets(getFilmOffset(index))) {
+        players.push_back(getPlayer(actorOffset));
+    }
+
+    return true;
+}
+
+int imdb::getNumPlayers() const {
+    if (isCompact()) return numCompactPlayers;
+    return *(int *) actorFile;
+}
+
+int imdb::getPlayerOffset(int index) const {
+    if (isCompact()) return index;
+    return ((int *) actorFile)[index + 1];
+}
+
+int imdb::findPlayer(string_view player) const {
+    return names.good() ? names.findPlayer(player, *this) : searchPlayers(player);
+}
+
+int imdb::searchPlayers(string_view player) const {
+    int low = 0, high = getNumPlayers();
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (comparePlayer(getPlayerOffset(mid), player) < 0) low = mid + 1;
+        else high = mid;
+    }
+    if (low == getNumPlayers() || comparePlayer(getPlayerOffset(low), player) != 0) return -1;
+    return low;
+}
+
+int imdb::getNumFilms() const {
+    if (isCompact()) return numCompactFilms;
+    return *(int *) movieFile;
+}
+
+int imdb::getFilmOffset(int index) const {
+    if (isCompact()) return index;
+    return ((int *) movieFile)[index + 1];
+}
+
+int imdb::findFilm(const filmView& movie) const {
+    return names.good() ? names.findFilm(movie, *this) : searchFilms(movie);
+}
+
+int imdb::searchFilms(const filmView& movie) const {
+    int low = 0, high = getNumFilms();
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (compareFilm(getFilmOffset(mid), movie) < 0) low = mid + 1;
+        else high = mid;
+    }
+    if (low == getNumFilms() || compareFilm(getFilmOffset(low), movie) != 0) return -1;
+    return low;
+}
+
+int imdb::compareFilm(int offset, const filmView& movie) const {
+    filmView record = getFilmView(offset);
+    int result = record.title.compare(movie.title);
+    if (result != 0) return result;
+    return record.year - movie.year;
+}
+
+creditsView imdb::getCreditsView(string_view player) const {
+    int index = findPlayer(player);
+    if (index < 0) return creditsView();
+
+    return creditsView(this, getCreditOffsets(getPlayerOffset(index)));
+}
+
+castView imdb::getCastView(const filmView& movie) const {
+    int index = findFilm(movie);
+    if (index < 0) return castView();
+
+    return castView(this, getCastOffsets(getFilmOffset(index)));
+}
+
+offsetList imdb::decodeList(const unsigned char *list) {
+    int count = 0;
+    for (int shift = 0; ; shift += 7) {
+        unsigned char byte = *list++;
+        count |= (byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) break;
+    }
+    return offsetList(list, count);
+}
+
+offsetList imdb::getCreditOffsets(int playerOffset) const {
+    if (isCompact()) return decodeList(creditLists + playerTable[2 * playerOffset + 1]);
 
     // Skip name
-    char *movie_ptr = (char *) movieFile + *movieOffset;
-    long titleSpaceUsed = movie.title.length() + 1;
+    char *player_ptr = (char *) actorFile + playerOffset;
+    long nameLength = strlen(player_ptr);
+    long nameSpaceUsed = (nameLength % 2 == 0) ? nameLength + 2 : nameLength + 1;
+    player_ptr += nameSpaceUsed;
+
+    // Skip number of movies
+    int count = *(short *) player_ptr;
+    player_ptr += ((nameSpaceUsed + 2) % 4 == 0) ? 2 : 4;
+    return offsetList((const int *) player_ptr, count);
+}
+
+offsetList imdb::getCastOffsets(int filmOffset) const {
+    if (isCompact()) return decodeList(castLists + filmTable[2 * filmOffset + 1]);
+
+    // Skip name
+    char *movie_ptr = (char *) movieFile + filmOffset;
+    long titleSpaceUsed = strlen(movie_ptr) + 1;
     movie_ptr += titleSpaceUsed;
 
     // Skip year
@@ -83,16 +244,114 @@ bool imdb::getCast(const film& movie, vector<string>& players) const {
     movie_ptr += yearSpaceUsed;
 
     // Skip number of actors
-    short numActors = *(short *) movie_ptr;
+    int count = *(short *) movie_ptr;
     movie_ptr += ((titleSpaceUsed + yearSpaceUsed + 2) % 4 == 0) ? 2 : 4;
+    return offsetList((const int *) movie_ptr, count);
+}
 
-    // Store all players into vector
-    for (short i=0; i<numActors; i++) {
-        players.push_back(getPlayer(*(int *) movie_ptr));
-        movie_ptr += 4;
+/**
+ * Function: appendVarint
+ * ----------------------
+ * Appends value to bytes as an LEB128 varint: seven bits per byte, least
+ * significant group first, with the high bit set on every byte but the last.
+ */
+static void appendVarint(vector<unsigned char>& bytes, uint32_t value) {
+    while (value >= 0x80) {
+        bytes.push_back((value & 0x7f) | 0x80);
+        value >>= 7;
     }
+    bytes.push_back(value);
+}
 
-    return true;
+/**
+ * Function: appendList
+ * --------------------
+ * Appends the compact encoding of one credit or cast list, translating each
+ * offset into an index via indices.  Lists keep their original order, so the
+ * differences are zigzag encoded to handle the occasional negative one.
+ */
+static void appendList(vector<unsigned char>& bytes, const offsetList& offsets,
+                       const unordered_map<int, int>& indices) {
+    appendVarint(bytes, offsets.size());
+    int previous = 0;
+    for (int offset: offsets) {
+        int index = indices.at(offset);
+        int delta = index - previous;
+        appendVarint(bytes, ((uint32_t) delta << 1) ^ (uint32_t) (delta >> 31));
+        previous = index;
+    }
+}
+
+static uint64_t alignUp(uint64_t offset) {
+    return (offset + sizeof(uint32_t) - 1) / sizeof(uint32_t) * sizeof(uint32_t);
+}
+
+bool imdb::writeCompact(const string& directory) const {
+    string pool;
+    unordered_map<string_view, uint32_t> pooled; // keys point into this imdb's mappings
+    auto intern = [&pool, &pooled](string_view str) -> uint32_t {
+        auto found = pooled.find(str);
+        if (found != pooled.end()) return found->second;
+        uint32_t start = pool.size();
+        pool.append(str);
+        pool.push_back('\0');
+        pooled[str] = start;
+        return start;
+    };
+
+    int numPlayers = getNumPlayers(), numFilms = getNumFilms();
+    unordered_map<int, int> playerIndices, filmIndices;
+    for (int i = 0; i < numPlayers; i++) playerIndices[getPlayerOffset(i)] = i;
+    for (int i = 0; i < numFilms; i++) filmIndices[getFilmOffset(i)] = i;
+
+    vector<uint32_t> players(2 * numPlayers), films(2 * numFilms);
+    string years(numFilms, '\0');
+    vector<unsigned char> credits, casts;
+    for (int i = 0; i < numPlayers; i++) {
+        int offset = getPlayerOffset(i);
+        players[2 * i] = intern(getPlayerView(offset));
+        players[2 * i + 1] = credits.size();
+        appendList(credits, getCreditOffsets(offset), filmIndices);
+    }
+    for (int i = 0; i < numFilms; i++) {
+        int offset = getFilmOffset(i);
+        filmView movie = getFilmView(offset);
+        films[2 * i] = intern(movie.title);
+        films[2 * i + 1] = casts.size();
+        years[i] = movie.year;
+        appendList(casts, getCastOffsets(offset), playerIndices);
+    }
+
+    compactHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kCompactMagic, sizeof(header.magic));
+    header.numPlayers = numPlayers;
+    header.numFilms = numFilms;
+    header.stringPoolStart = sizeof(header);
+    header.playerTableStart = alignUp(header.stringPoolStart + pool.size());
+    header.filmTableStart = header.playerTableStart + players.size() * sizeof(uint32_t);
+    header.filmYearsStart = header.filmTableStart + films.size() * sizeof(uint32_t);
+    header.creditListsStart = header.filmYearsStart + years.size();
+    header.castListsStart = header.creditListsStart + credits.size();
+
+    // write to a temporary file and rename it into place, so that readers never see a partial file
+    const string fileName = directory + "/" + kCompactFileName;
+    const string tempFileName = fileName + ".tmp";
+    ofstream out(tempFileName, ios::binary | ios::trunc);
+    out.write((const char *) &header, sizeof(header));
+    out.write(pool.data(), pool.size());
+    out.write("\0\0\0", header.playerTableStart - header.stringPoolStart - pool.size());
+    out.write((const char *) players.data(), players.size() * sizeof(uint32_t));
+    out.write((const char *) films.data(), films.size() * sizeof(uint32_t));
+    out.write(years.data(), years.size());
+    out.write((const char *) credits.data(), credits.size());
+    out.write((const char *) casts.data(), casts.size());
+    out.close();
+    if (out.fail()) {
+        unlink(tempFileName.c_str());
+        return false;
+    }
+    return rename(tempFileName.c_str(), fileName.c_str()) == 0;
 }
 
 const void *imdb::acquireFileMap(const string& fileName, struct fileInfo& info) {
@@ -1,8 +1,151 @@
 #pragma once
 #include "imdb-utils.h"
+#include "name-index.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <string>
+#include <string_view>
 #include <vector>
 
+class imdb;
+
+/**
+ * Class: offsetList
+ * -----------------
+ * A forward range over one of the lists of record offsets embedded in the
+ * imdb data files (the credits inside an actor record, or the cast list
+ * inside a movie record).  In the original format the list is a plain array
+ * of ints inside the mapped file; in the compact format (see imdb::writeCompact)
+ * it's a sequence of variable-length, delta-encoded integers, which the
+ * iterator decodes as it advances.  Either way, nothing is copied.
+ */
+class offsetList {
+ public:
+  class iterator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef int value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const int *pointer;
+    typedef int reference;
+
+    iterator(const int *raw, int remaining) : raw(raw), encoded(nullptr), remaining(remaining), value(0) {}
+    iterator(const unsigned char *encoded, int remaining) : raw(nullptr), encoded(encoded), remaining(remaining), value(0) {
+      if (remaining > 0) decode();
+    }
+
+    int operator*() const { return raw != nullptr ? *raw : value; }
+    iterator& operator++() { advance(); return *this; }
+    iterator operator++(int) { iterator old = *this; advance(); return old; }
+    bool operator==(const iterator& rhs) const { return remaining == rhs.remaining; }
+    bool operator!=(const iterator& rhs) const { return remaining != rhs.remaining; }
+
+   private:
+    const int *raw;
+    const unsigned char *encoded;
+    int remaining;
+    int value;
+
+    void advance() {
+      remaining--;
+      if (raw != nullptr) raw++;
+      else if (remaining > 0) decode();
+    }
+
+    // reads one LEB128 varint holding the zigzag-encoded difference from the previous value
+    void decode() {
+      uint32_t bits = 0;
+      for (int shift = 0; ; shift += 7) {
+        unsigned char byte = *encoded++;
+        bits |= (uint32_t) (byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) break;
+      }
+      value += (int) ((bits >> 1) ^ -(bits & 1));
+    }
+  };
+
+  offsetList() : raw(nullptr), encoded(nullptr), count(0) {}
+  offsetList(const int *raw, int count) : raw(raw), encoded(nullptr), count(count) {}
+  offsetList(const unsigned char *encoded, int count) : raw(nullptr), encoded(encoded), count(count) {}
+
+  iterator begin() const { return raw != nullptr ? iterator(raw, count) : iterator(encoded, count); }
+  iterator end() const { return iterator(raw, 0); }
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+
+ private:
+  const int *raw;
+  const unsigned char *encoded;
+  int count;
+};
+
+/**
+ * Class template: recordRange
+ * ---------------------------
+ * A lightweight, iterable range over the records named by an offsetList.
+ * Dereferencing an iterator decodes the record at the current offset in
+ * place, via the supplied Decoder, so iterating over a recordRange never
+ * allocates or copies.  Ranges and everything they produce are only valid
+ * for as long as the imdb that handed them out.
+ */
+template <typename Decoder>
+class recordRange {
+ public:
+  class iterator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef decltype(Decoder()(nullptr, 0)) value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const value_type *pointer;
+    typedef value_type reference;
+
+    iterator(const imdb *db, offsetList::iterator offset) : db(db), offset(offset) {}
+    value_type operator*() const { return Decoder()(db, *offset); }
+    iterator& operator++() { ++offset; return *this; }
+    iterator operator++(int) { iterator old = *this; ++offset; return old; }
+    bool operator==(const iterator& rhs) const { return offset == rhs.offset; }
+    bool operator!=(const iterator& rhs) const { return offset != rhs.offset; }
+
+    // offset of the current record, as understood by imdb::getPlayer, imdb::getFilm, etc.
+    int getOffset() const { return *offset; }
+
+   private:
+    const imdb *db;
+    offsetList::iterator offset;
+  };
+
+  recordRange() : db(nullptr) {}
+  recordRange(const imdb *db, const offsetList& offsets) : db(db), offsets(offsets) {}
+
+  iterator begin() const { return iterator(db, offsets.begin()); }
+  iterator end() const { return iterator(db, offsets.end()); }
+  size_t size() const { return offsets.size(); }
+  bool empty() const { return offsets.empty(); }
+
+ private:
+  const imdb *db;
+  offsetList offsets;
+};
+
+/**
+ * Types: playerDecoder, filmDecoder
+ * ---------------------------------
+ * Decoders that view the actor record or the movie record at the given
+ * offset without copying anything.
+ */
+struct playerDecoder {
+  std::string_view operator()(const imdb *db, int offset) const;
+};
+
+struct filmDecoder {
+  filmView operator()(const imdb *db, int offset) const;
+};
+
+typedef recordRange<filmDecoder> creditsView;
+typedef recordRange<playerDecoder> castView;
+
 class imdb {
  public:
   
@@ -15,6 +158,14 @@ class imdb {
  * all of the information about the movies and actors relevant to an IMDB
  * application (like six-degrees).
  *
+ * Two formats are understood.  If the directory holds a compactdata file
+ * (written by writeCompact, usually via convert-imdb), that file alone backs
+ * the imdb.  Otherwise the original actordata and moviedata files are used.
+ * Every method behaves identically either way, except that what the methods
+ * below call a record's "offset" is only meaningful to the imdb that handed
+ * it out: it's a byte offset into a data file in the original format, but
+ * simply the record's index in the compact one.
+ *
  * @param directory the name of the directory housing the formatted information backing the imdb.
  */
 
@@ -26,7 +177,8 @@ class imdb {
  * Returns true if and only if the imdb opened without indicident.
  * imdb::good would typically return false if:
  *
- *     1.) either one or both of the data files supporting the imdb were missing
+ *     1.) either one or both of the data files supporting the imdb were missing,
+ *         or the compact data file was present but malformed
  *     2.) the directory passed to the constructor doesn't exist.
  *     3.) the directory and files all exist, but you don't have the permission to read them.
  */
@@ -74,6 +226,146 @@ class imdb {
 
   const film getFilm(int offset) const;
 
+/**
+ * Methods: getNumPlayers, getPlayerOffset, findPlayer
+ * ---------------------------------------------------
+ * Low-level access to the sorted table of actor records.  Players are
+ * identified by their index into that table (0 through getNumPlayers() - 1),
+ * and getPlayerOffset maps an index to the byte offset of the player's record,
+ * which is what getPlayer, getCreditOffsets, and the cast lists inside
+ * movie records all deal in.  findPlayer looks the named actor/actress up
+ * and returns that player's index, or -1 if there isn't one.  It consults
+ * the name index when there is one (see hasNameIndex) and binary searches
+ * the table otherwise.
+ */
+  int getNumPlayers() const;
+  int getPlayerOffset(int index) const;
+  int findPlayer(std::string_view player) const;
+
+/**
+ * Methods: getNumFilms, getFilmOffset, findFilm
+ * ---------------------------------------------
+ * Same as the three methods above, except that they operate on the sorted
+ * table of movie records.
+ */
+  int getNumFilms() const;
+  int getFilmOffset(int index) const;
+  int findFilm(const filmView& movie) const;
+
+/**
+ * Methods: searchPlayers, searchFilms
+ * -----------------------------------
+ * The binary searches findPlayer and findFilm fall back on when there's no
+ * name index.  They return exactly what findPlayer and findFilm do, and are
+ * exposed mostly so the two lookup strategies can be compared.
+ */
+  int searchPlayers(std::string_view player) const;
+  int searchFilms(const filmView& movie) const;
+
+/**
+ * Predicate Method: hasNameIndex
+ * ------------------------------
+ * Returns true if and only if a nameindex file matching the data files was
+ * found (and mapped) when the imdb was constructed.  See name-index.h.
+ */
+  bool hasNameIndex() const { return names.good(); }
+
+/**
+ * Methods: getActorFileSize, getMovieFileSize, getCompactFileSize
+ * ---------------------------------------------------------------
+ * Self-explanatory.  Each returns 0 if its file isn't the one backing the
+ * imdb: the first two when it's backed by a compact data file, and the third
+ * when it isn't.
+ */
+  size_t getActorFileSize() const { return actorInfo.fileSize; }
+  size_t getMovieFileSize() const { return movieInfo.fileSize; }
+  size_t getCompactFileSize() const { return compactInfo.fileSize; }
+
+/**
+ * Method: getDataStamp
+ * --------------------
+ * Returns the stamp of the data files backing the imdb, which is what the
+ * indices built from them record and check.
+ */
+  dataStamp getDataStamp() const {
+    return dataStamp { getActorFileSize(), getMovieFileSize(), getCompactFileSize() };
+  }
+
+/**
+ * Predicate Method: isCompact
+ * ---------------------------
+ * Returns true if and only if the imdb is backed by a compact data file.
+ */
+  bool isCompact() const { return stringPool != nullptr; }
+
+/**
+ * Method: writeCompact
+ * --------------------
+ * Writes everything in the receiving imdb to a compactdata file in the
+ * specified directory.  Compared to actordata and moviedata, the compact
+ * format stores each distinct name or title once in a shared string pool,
+ * records are located through fixed-size tables instead of padded in place,
+ * and every credit and cast list is a run of variable-length integers, each
+ * holding the (usually small) difference from the previous entry's index.
+ * Returns true if and only if the file was written successfully.
+ */
+  bool writeCompact(const std::string& directory) const;
+
+/**
+ * Methods: getCreditOffsets, getCastOffsets
+ * -----------------------------------------
+ * Returns the list of movie record offsets embedded within the player record
+ * at the specified offset (or the list of player record offsets embedded within
+ * the specified movie record).  No copies are made--the list is read straight
+ * out of the underlying data file as it's iterated over.
+ */
+  offsetList getCreditOffsets(int playerOffset) const;
+  offsetList getCastOffsets(int filmOffset) const;
+
+/**
+ * Methods: getCreditsView, getCastView
+ * ------------------------------------
+ * Zero-copy versions of getCredits and getCast.  Rather than filling a vector
+ * with freshly allocated films or strings, they return a range whose elements
+ * (filmViews and std::string_views, respectively) point directly into the
+ * memory-mapped data files.  If the actor/actress or movie doesn't exist, the
+ * returned range is empty.
+ *
+ *    for (const filmView& movie: db.getCreditsView("Kevin Bacon"))
+ *      for (std::string_view costar: db.getCastView(movie))
+ *        ...
+ */
+  creditsView getCreditsView(std::string_view player) const;
+  castView getCastView(const filmView& movie) const;
+
+/**
+ * Methods: getPlayerView, getFilmView
+ * -----------------------------------
+ * Zero-copy versions of getPlayer and getFilm.
+ */
+  std::string_view getPlayerView(int offset) const {
+    if (isCompact()) return stringPool + playerTable[2 * offset];
+    return (const char *) actorFile + offset;
+  }
+
+  filmView getFilmView(int offset) const {
+    if (isCompact()) return filmView(stringPool + filmTable[2 * offset], filmYears[offset]);
+    std::string_view title = (const char *) movieFile + offset;
+    return filmView(title, title.data()[title.size() + 1]);
+  }
+
+/**
+ * Methods: comparePlayer, compareFilm
+ * -----------------------------------
+ * Compares the record at the specified offset against the supplied name (or
+ * title and year) in place, returning a negative number, zero, or a positive
+ * number depending on whether the record sorts before, the same as, or after
+ * it.  These are what the binary searches behind findPlayer and findFilm use,
+ * so no probe ever allocates.
+ */
+  int comparePlayer(int offset, std::string_view player) const { return getPlayerView(offset).compare(player); }
+  int compareFilm(int offset, const filmView& movie) const;
+
 /**
  * Destructor: ~imdb
  * -----------------
@@ -85,8 +377,19 @@ class imdb {
  private:
   static const char *const kActorFileName;
   static const char *const kMovieFileName;
+  static const char *const kCompactFileName;
   const void *actorFile;
   const void *movieFile;
+
+  // sections of the compact data file, all null when the original format is in use
+  const char *stringPool;
+  const uint32_t *playerTable;      // (name, credits) pairs, relative to stringPool and creditLists
+  const uint32_t *filmTable;        // (title, cast) pairs, relative to stringPool and castLists
+  const char *filmYears;
+  const unsigned char *creditLists;
+  const unsigned char *castLists;
+  int numCompactPlayers;
+  int numCompactFilms;
   
   // everything below here is complicated and needn't be touched.
   // you're free to investigate, but you're on your own.
@@ -94,12 +397,23 @@ class imdb {
     int fd;
     size_t fileSize;
     const void *fileMap;
-  } actorInfo, movieInfo;
+  } actorInfo, movieInfo, compactInfo;
+  nameIndex names;
   
   static const void *acquireFileMap(const std::string& fileName, struct fileInfo& info);
   static void releaseFileMap(struct fileInfo& info);
+  bool openCompact(const std::string& fileName);
+  static offsetList decodeList(const unsigned char *list);
 
   imdb(const imdb& original) = delete;
   imdb& operator=(const imdb& rhs) = delete;
   imdb& operator=(const imdb& rhs) const = delete;
 };
+
+inline std::string_view playerDecoder::operator()(const imdb *db, int offset) const {
+  return db->getPlayerView(offset);
+}
+
+inline filmView filmDecoder::operator()(const imdb *db, int offset) const {
+  return db->getFilmView(offset);
+}
@@ -0,0 +1,167 @@
+/**
+ * File: landmarks.cc
+ * ------------------
+ * Presents the implementation of the landmarkIndex class.  The landmarks file
+ * is laid out as follows:
+ *
+ *     header:    magic string, landmark count (uint32_t), actor count (uint32_t),
+ *                and the stamp of the data files it was built from (see dataStamp)
+ *     landmarks: the actor id of every landmark (uint32_t each)
+ *     distances: one row of actor-count bytes per landmark, in landmark order
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include "landmarks.h"
+#include "thread-pool.h"
+using namespace std;
+
+static const char *const kLandmarkFileName = "landmarks";
+static const char kLandmarkMagic[8] = {'L', 'A', 'N', 'D', 'M', 'R', 'K', '3'};
+
+struct landmarkHeader {
+  char magic[8];
+  uint32_t numLandmarks;
+  uint32_t numActors;
+  dataStamp stamp;
+};
+
+/**
+ * Function: chooseLandmarks
+ * -------------------------
+ * Ranks every actor by the total size of the casts they appeared in--a
+ * cheap stand-in for the number of costars--and returns the top numLandmarks.
+ */
+static vector<uint32_t> chooseLandmarks(const graph& g, size_t numLandmarks) {
+  vector<uint64_t> scores(g.getNumActors(), 0);
+  for (uint32_t actor = 0; actor < g.getNumActors(); actor++) {
+    auto credits = g.getCredits(actor);
+    for (const uint32_t *f = credits.first; f != credits.second; f++) {
+      auto cast = g.getCast(*f);
+      scores[actor] += cast.second - cast.first;
+    }
+  }
+
+  vector<uint32_t> actors(g.getNumActors());
+  for (uint32_t actor = 0; actor < actors.size(); actor++) actors[actor] = actor;
+  numLandmarks = min(numLandmarks, actors.size());
+  partial_sort(actors.begin(), actors.begin() + numLandmarks, actors.end(), [&](uint32_t a, uint32_t b) {
+    return scores[a] > scores[b] || (scores[a] == scores[b] && a < b);
+  });
+  actors.resize(numLandmarks);
+  return actors;
+}
+
+bool landmarkIndex::build(const imdb& db, size_t numLandmarks, size_t numThreads, const string& directory) {
+  graph g(db);
+  vector<uint32_t> landmarks = chooseLandmarks(g, numLandmarks);
+  vector<vector<uint8_t>> rows(landmarks.size());
+  {
+    ThreadPool pool(numThreads);
+    for (size_t i = 0; i < landmarks.size(); i++) {
+      pool.schedule([&g, &landmarks, &rows, i] {
+        g.computeDistances(landmarks[i], rows[i]);
+      });
+    }
+  }
+
+  // write to a temporary file and rename it into place, so that readers never see a partial index
+  const string fileName = directory + "/" + kLandmarkFileName;
+  const string tempFileName = fileName + ".tmp";
+  ofstream out(tempFileName, ios::binary | ios::trunc);
+  landmarkHeader header;
+  memcpy(header.magic, kLandmarkMagic, sizeof(header.magic));
+  header.numLandmarks = landmarks.size();
+  header.numActors = g.getNumActors();
+  header.stamp = db.getDataStamp();
+  out.write((const char *) &header, sizeof(header));
+  out.write((const char *) landmarks.data(), landmarks.size() * sizeof(uint32_t));
+  for (const vector<uint8_t>& row: rows) out.write((const char *) row.data(), row.size());
+  out.close();
+  if (out.fail()) {
+    unlink(tempFileName.c_str());
+    return false;
+  }
+  return rename(tempFileName.c_str(), fileName.c_str()) == 0;
+}
+
+landmarkIndex::landmarkIndex(const string& directory, const imdb& db) :
+  numActors(db.getNumPlayers()), numLandmarks(0), distances(NULL), fd(-1), fileSize(0), fileMap(NULL) {
+  const string fileName = directory + "/" + kLandmarkFileName;
+  fd = open(fileName.c_str(), O_RDONLY);
+  if (fd == -1) return;
+  struct stat stats;
+  if (fstat(fd, &stats) == -1 || stats.st_size < (off_t) sizeof(landmarkHeader)) return;
+  fileSize = stats.st_size;
+  void *map = mmap(0, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+  if (map == MAP_FAILED) return;
+  fileMap = map;
+
+  const landmarkHeader *header = (const landmarkHeader *) fileMap;
+  size_t expectedSize = sizeof(landmarkHeader) +
+    header->numLandmarks * (sizeof(uint32_t) + (size_t) header->numActors);
+  if (memcmp(header->magic, kLandmarkMagic, sizeof(kLandmarkMagic)) != 0 ||
+      header->numActors != numActors ||
+      header->stamp != db.getDataStamp() ||
+      fileSize != expectedSize) return;
+
+  numLandmarks = header->numLandmarks;
+  distances = (const uint8_t *) (header + 1) + numLandmarks * sizeof(uint32_t);
+}
+
+landmarkIndex::~landmarkIndex() {
+  if (fileMap != NULL) munmap((void *) fileMap, fileSize);
+  if (fd != -1) close(fd);
+}
+
+void landmarkIndex::getBounds(uint32_t source, uint32_t target, int& lower, int& upper) const {
+  lower = 1;
+  upper = kUnreachableDistance;
+  const uint8_t *row = distances;
+  for (size_t i = 0; i < numLandmarks; i++, row += numActors) {
+    int fromSource = row[source], fromTarget = row[target];
+    if (fromSource == kUnreachableDistance && fromTarget == kUnreachableDistance) continue;
+    if (fromSource == kUnreachableDistance || fromTarget == kUnreachableDistance) {
+      lower = upper = kUnreachableDistance; // different components
+      return;
+    }
+    lower = max(lower, abs(fromSource - fromTarget));
+    upper = min(upper, fromSource + fromTarget);
+  }
+}
+
+bool landmarkIndex::getProvenDistance(uint32_t source, uint32_t target, int maxHops, int& distance) const {
+  if (source == target) {
+    distance = 0;
+    return true;
+  }
+
+  int lower, upper;
+  getBounds(source, target, lower, upper);
+  if (lower == kUnreachableDistance || lower > maxHops) {
+    distance = -1;
+    return true;
+  }
+  if (lower != upper) return false;
+  distance = lower;
+  return true;
+}
+
+int landmarkIndex::getDistance(const graph& g, uint32_t source, uint32_t target, int maxHops) const {
+  int distance;
+  if (getProvenDistance(source, target, maxHops, distance)) return distance;
+
+  int lower, upper;
+  getBounds(source, target, lower, upper);
+  vector<pair<uint32_t, uint32_t>> links;
+  if (g.findShortestPath(source, target, min(upper - 1, maxHops), links)) return links.size();
+  return (upper <= maxHops) ? upper : -1;
+}
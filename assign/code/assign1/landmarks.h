@@ -0,0 +1,110 @@
+/**
+ * File: landmarks.h
+ * -----------------
+ * Exports the landmarkIndex class, which answers "how many degrees apart are
+ * these two actors?" without running a full search in the common case.
+ *
+ * An index is built offline by choosing a handful of well-connected landmark
+ * actors and recording the distance from each of them to every actor in the
+ * graph.  By the triangle inequality, for any landmark L,
+ *
+ *     |d(L, s) - d(L, t)| <= d(s, t) <= d(L, s) + d(L, t)
+ *
+ * so the best lower and upper bounds over all landmarks often pin the distance
+ * down exactly.  When they don't, only a search bounded by the upper bound is
+ * needed.  The distances are stored one byte apiece in a file named
+ * "landmarks" alongside actordata and moviedata, and that file is memory
+ * mapped rather than read when the index is opened.  Opening the index and
+ * consulting the bounds need only the imdb, so the graph (which takes far
+ * longer to build than any of this) is only built when a search is needed.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "imdb.h"
+#include "graph.h"
+
+class landmarkIndex {
+ public:
+
+/**
+ * Static Method: build
+ * --------------------
+ * Builds the graph of db, picks the numLandmarks actors with the most costar
+ * appearances, runs a full breadth-first search from each (spread across
+ * numThreads threads), and writes the resulting index to the landmarks file in
+ * the specified directory, which should be the one db was opened on.  Returns
+ * true if and only if the file was written successfully.
+ */
+  static bool build(const imdb& db, size_t numLandmarks, size_t numThreads, const std::string& directory);
+
+/**
+ * Constructor: landmarkIndex
+ * --------------------------
+ * Maps the landmarks file in the specified directory, if there is one.  The
+ * index is only usable (see good) if the file exists, is well formed, and was
+ * built from exactly the data files db is backed by.  Actors are identified
+ * by the ids db.findPlayer returns, which are also the graph's actor ids.
+ */
+  landmarkIndex(const std::string& directory, const imdb& db);
+  ~landmarkIndex();
+
+/**
+ * Predicate Method: good
+ * ----------------------
+ * Returns true if and only if the index was found and mapped without incident.
+ */
+  bool good() const { return distances != NULL; }
+
+/**
+ * Method: getNumLandmarks
+ * -----------------------
+ * Self-explanatory.
+ */
+  size_t getNumLandmarks() const { return numLandmarks; }
+
+/**
+ * Method: getBounds
+ * -----------------
+ * Computes the tightest landmark bounds on the distance between source and
+ * target.  If some landmark reaches one but not the other, the two are known
+ * to be disconnected, and both bounds are set to kUnreachableDistance.  If no
+ * landmark reaches either, nothing is known, and lower and upper are set to
+ * 1 and kUnreachableDistance, respectively.
+ */
+  void getBounds(uint32_t source, uint32_t target, int& lower, int& upper) const;
+
+/**
+ * Method: getProvenDistance
+ * -------------------------
+ * Returns true if the landmark bounds alone settle how many films separate
+ * source and target, setting distance to that number, or to -1 if the two
+ * aren't connected by a chain of at most maxHops films.  Returns false, leaving
+ * distance alone, if only a search can tell.
+ */
+  bool getProvenDistance(uint32_t source, uint32_t target, int maxHops, int& distance) const;
+
+/**
+ * Method: getDistance
+ * -------------------
+ * Returns the number of films separating source and target, answering straight
+ * from the landmark bounds whenever they prove the distance, and otherwise falling
+ * back on a bidirectional search of g (the graph of the same imdb) bounded by both
+ * the upper bound and maxHops.  Returns -1 if the two actors aren't connected by a
+ * chain of at most maxHops films.
+ */
+  int getDistance(const graph& g, uint32_t source, uint32_t target, int maxHops) const;
+
+ private:
+  size_t numActors;
+  size_t numLandmarks;
+  const uint8_t *distances;  // numLandmarks rows of numActors distances each
+  int fd;
+  size_t fileSize;
+  const void *fileMap;
+
+  landmarkIndex(const landmarkIndex& original) = delete;
+  landmarkIndex& operator=(const landmarkIndex& rhs) = delete;
+};
@@ -0,0 +1,176 @@
+/**
+ * File: name-index.cc
+ * -------------------
+ * Presents the implementation of the nameIndex class.  The nameindex file is
+ * laid out as follows:
+ *
+ *     header:  magic string, record counts and table sizes (uint32_t each),
+ *              and the stamp of the data files indexed (see dataStamp)
+ *     players: the actor hash table, one (hash, index) slot per entry
+ *     films:   the movie hash table, laid out the same way
+ *
+ * Both tables use linear probing and are sized to the smallest power of two
+ * that keeps them at most half full.
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "name-index.h"
+#include "imdb.h"
+using namespace std;
+
+static const char *const kNameIndexFileName = "nameindex";
+static const char kNameIndexMagic[8] = {'N', 'A', 'M', 'E', 'I', 'D', 'X', '2'};
+static const uint32_t kFNVOffsetBasis = 2166136261u;
+static const uint32_t kFNVPrime = 16777619u;
+
+struct nameIndexHeader {
+  char magic[8];
+  uint32_t numPlayers;
+  uint32_t numFilms;
+  uint32_t numPlayerSlots;
+  uint32_t numFilmSlots;
+  dataStamp stamp;
+};
+
+static uint32_t hashBytes(uint32_t hash, const char *bytes, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    hash ^= (unsigned char) bytes[i];
+    hash *= kFNVPrime;
+  }
+  return hash;
+}
+
+uint32_t nameIndex::hashPlayer(string_view player) {
+  return hashBytes(kFNVOffsetBasis, player.data(), player.size());
+}
+
+uint32_t nameIndex::hashFilm(const filmView& movie) {
+  char year = movie.year;
+  return hashBytes(hashBytes(kFNVOffsetBasis, movie.title.data(), movie.title.size()), &year, 1);
+}
+
+/**
+ * Function: tableSize
+ * -------------------
+ * Returns the smallest power of two that's at least twice numEntries.
+ */
+static uint32_t tableSize(uint32_t numEntries) {
+  uint32_t size = 1;
+  while (size < 2 * numEntries) size *= 2;
+  return size;
+}
+
+/**
+ * Function: buildTable
+ * --------------------
+ * Builds one linear-probing table, where hashOf(i) supplies the hash of the
+ * record with index i.
+ */
+template <typename Hasher>
+static vector<uint32_t> buildTable(uint32_t numEntries, Hasher hashOf) {
+  uint32_t mask = tableSize(numEntries) - 1;
+  vector<uint32_t> table(2 * (mask + 1));
+  for (uint32_t s = 0; s <= mask; s++) table[2 * s + 1] = (uint32_t) -1;
+  for (uint32_t i = 0; i < numEntries; i++) {
+    uint32_t hash = hashOf(i);
+    uint32_t s = hash & mask;
+    while (table[2 * s + 1] != (uint32_t) -1) s = (s + 1) & mask;
+    table[2 * s] = hash;
+    table[2 * s + 1] = i;
+  }
+  return table;
+}
+
+bool nameIndex::build(const imdb& db, const string& directory) {
+  vector<uint32_t> players = buildTable(db.getNumPlayers(), [&db](uint32_t i) {
+    return hashPlayer(db.getPlayerView(db.getPlayerOffset(i)));
+  });
+  vector<uint32_t> films = buildTable(db.getNumFilms(), [&db](uint32_t i) {
+    return hashFilm(db.getFilmView(db.getFilmOffset(i)));
+  });
+
+  nameIndexHeader header;
+  memcpy(header.magic, kNameIndexMagic, sizeof(header.magic));
+  header.numPlayers = db.getNumPlayers();
+  header.numFilms = db.getNumFilms();
+  header.numPlayerSlots = players.size() / 2;
+  header.numFilmSlots = films.size() / 2;
+  header.stamp = db.getDataStamp();
+
+  // write to a temporary file and rename it into place, so that readers never see a partial index
+  const string fileName = directory + "/" + kNameIndexFileName;
+  const string tempFileName = fileName + ".tmp";
+  ofstream out(tempFileName, ios::binary | ios::trunc);
+  out.write((const char *) &header, sizeof(header));
+  out.write((const char *) players.data(), players.size() * sizeof(uint32_t));
+  out.write((const char *) films.data(), films.size() * sizeof(uint32_t));
+  out.close();
+  if (out.fail()) {
+    unlink(tempFileName.c_str());
+    return false;
+  }
+  return rename(tempFileName.c_str(), fileName.c_str()) == 0;
+}
+
+nameIndex::nameIndex() :
+  playerSlots(NULL), filmSlots(NULL), playerMask(0), filmMask(0), fd(-1), fileSize(0), fileMap(NULL) {}
+
+nameIndex::~nameIndex() {
+  if (fileMap != NULL) munmap((void *) fileMap, fileSize);
+  if (fd != -1) close(fd);
+}
+
+bool nameIndex::open(const string& directory, int numPlayers, int numFilms, const dataStamp& stamp) {
+  const string fileName = directory + "/" + kNameIndexFileName;
+  fd = ::open(fileName.c_str(), O_RDONLY);
+  if (fd == -1) return false;
+  struct stat stats;
+  if (fstat(fd, &stats) == -1 || stats.st_size < (off_t) sizeof(nameIndexHeader)) return false;
+  fileSize = stats.st_size;
+  void *map = mmap(0, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+  if (map == MAP_FAILED) return false;
+  fileMap = map;
+
+  const nameIndexHeader *header = (const nameIndexHeader *) fileMap;
+  size_t expectedSize = sizeof(nameIndexHeader) +
+    ((size_t) header->numPlayerSlots + header->numFilmSlots) * sizeof(slot);
+  if (memcmp(header->magic, kNameIndexMagic, sizeof(kNameIndexMagic)) != 0 ||
+      header->numPlayers != (uint32_t) numPlayers || header->numFilms != (uint32_t) numFilms ||
+      header->numPlayerSlots != tableSize(numPlayers) || header->numFilmSlots != tableSize(numFilms) ||
+      header->stamp != stamp ||
+      fileSize != expectedSize) return false;
+
+  playerMask = header->numPlayerSlots - 1;
+  filmMask = header->numFilmSlots - 1;
+  playerSlots = (const slot *) (header + 1);
+  filmSlots = playerSlots + header->numPlayerSlots;
+  return true;
+}
+
+int nameIndex::findPlayer(string_view player, const imdb& db) const {
+  uint32_t hash = hashPlayer(player);
+  for (uint32_t s = hash & playerMask; playerSlots[s].index != -1; s = (s + 1) & playerMask) {
+    const slot& candidate = playerSlots[s];
+    if (candidate.hash == hash && db.comparePlayer(db.getPlayerOffset(candidate.index), player) == 0)
+      return candidate.index;
+  }
+  return -1;
+}
+
+int nameIndex::findFilm(const filmView& movie, const imdb& db) const {
+  uint32_t hash = hashFilm(movie);
+  for (uint32_t s = hash & filmMask; filmSlots[s].index != -1; s = (s + 1) & filmMask) {
+    const slot& candidate = filmSlots[s];
+    if (candidate.hash == hash && db.compareFilm(db.getFilmOffset(candidate.index), movie) == 0)
+      return candidate.index;
+  }
+  return -1;
+}
@@ -0,0 +1,96 @@
+/**
+ * File: name-index.h
+ * ------------------
+ * Exports the nameIndex class, an optional side index that lets an imdb map
+ * an actor's name or a film's title and year straight to the record's index
+ * in the sorted tables, without binary searching them.
+ *
+ * A binary search over the actor table probes about twenty records, each on
+ * a different page of the data file.  The name index replaces that with two
+ * open-addressing hash tables (one for actors, one for films) stored in a file
+ * named "nameindex" alongside actordata and moviedata.  Every slot records
+ * the full 32-bit hash of its key next to the record's index, so a lookup
+ * typically touches one slot and then exactly one record to confirm the
+ * match.  The file is built offline by build-name-index and memory mapped
+ * (never read) by the imdb constructor whenever it's present and matches the
+ * data files it sits beside.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "imdb-utils.h"
+
+class imdb;
+
+class nameIndex {
+ public:
+
+/**
+ * Static Method: build
+ * --------------------
+ * Hashes every actor and film in db and writes the resulting index to the
+ * nameindex file in the specified directory, which should be the one db was
+ * opened on.  Returns true if and only if the file was written successfully.
+ */
+  static bool build(const imdb& db, const std::string& directory);
+
+/**
+ * Static Methods: hashPlayer, hashFilm
+ * ------------------------------------
+ * The hash functions (32-bit FNV-1a) the index is built with.  A film's hash
+ * covers both its title and its year.
+ */
+  static uint32_t hashPlayer(std::string_view player);
+  static uint32_t hashFilm(const filmView& movie);
+
+  nameIndex();
+  ~nameIndex();
+
+/**
+ * Method: open
+ * ------------
+ * Maps the nameindex file in the specified directory, provided it exists, is
+ * well formed, and was built from data files with exactly the specified
+ * stamp and record counts.  Returns true if and only if the index
+ * is usable afterwards; otherwise, good will return false.
+ */
+  bool open(const std::string& directory, int numPlayers, int numFilms, const dataStamp& stamp);
+
+/**
+ * Predicate Method: good
+ * ----------------------
+ * Returns true if and only if an index was opened and mapped without incident.
+ */
+  bool good() const { return playerSlots != NULL; }
+
+/**
+ * Methods: findPlayer, findFilm
+ * -----------------------------
+ * Looks the specified actor/actress (or movie) up in the hash table and
+ * confirms any candidate against the record in db, returning the same index
+ * imdb::findPlayer (or imdb::findFilm) would, or -1 if there's no such record.
+ * Only meaningful when good returns true.
+ */
+  int findPlayer(std::string_view player, const imdb& db) const;
+  int findFilm(const filmView& movie, const imdb& db) const;
+
+ private:
+  struct slot {
+    uint32_t hash;
+    int32_t index;  // -1 if the slot is empty
+  };
+
+  const slot *playerSlots;
+  const slot *filmSlots;
+  uint32_t playerMask;  // number of player slots - 1 (always a power of two)
+  uint32_t filmMask;
+  int fd;
+  size_t fileSize;
+  const void *fileMap;
+
+  nameIndex(const nameIndex& original) = delete;
+  nameIndex& operator=(const nameIndex& rhs) = delete;
+};
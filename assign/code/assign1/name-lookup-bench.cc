@@ -0,0 +1,114 @@
+/**
+ * File: name-lookup-bench.cc
+ * --------------------------
+ * Microbenchmark comparing the two ways an imdb can find a record by name:
+ * binary searching the sorted tables (searchPlayers, searchFilms) and probing
+ * the hashed name index (findPlayer, findFilm, once build-name-index has been
+ * run).  Every actor and every film is looked up once per round, in a fixed
+ * pseudorandom order, and the two strategies are checked against each other.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "imdb.h"
+
+using namespace std;
+
+static const int kDatabaseNotFound = 2;
+static const int kUnrecognizedFlag = 3;
+static const int kLookupMismatch = 5;
+
+static const string kRoundsFlag = "--rounds=";
+static const int kDefaultNumRounds = 5;
+
+/**
+ * Function: timeLookups
+ * ---------------------
+ * Looks up every key numRounds times with the supplied function, and returns
+ * the average time per lookup in nanoseconds.  The indices found are summed
+ * into checksum so the compiler can't discard the lookups.
+ */
+template <typename Key, typename Lookup>
+static double timeLookups(const vector<Key>& keys, int numRounds, Lookup lookup, long& checksum) {
+  checksum = 0;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  for (int round = 0; round < numRounds; round++) {
+    for (const Key& key: keys) checksum += lookup(key);
+  }
+  double elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+  return keys.empty() ? 0 : elapsed / (keys.size() * numRounds);
+}
+
+/**
+ * Function: report
+ * ----------------
+ * Prints one line per strategy, plus the speedup if both were timed.
+ */
+static void report(const string& noun, size_t count, double searchTime, double hashTime, bool hashed) {
+  cout << noun << " (" << count << " lookups per round):" << endl;
+  cout << "    binary search: " << searchTime << " ns/lookup" << endl;
+  if (!hashed) {
+    cout << "    name index:    not found (run build-name-index first)" << endl;
+    return;
+  }
+  cout << "    name index:    " << hashTime << " ns/lookup (" << searchTime / hashTime << "x)" << endl;
+}
+
+int main(int argc, char *argv[]) {
+  int numRounds = kDefaultNumRounds;
+  for (int i = 1; i < argc; i++) {
+    const string flag = argv[i];
+    if (flag.compare(0, kRoundsFlag.size(), kRoundsFlag) == 0 && atoi(argv[i] + kRoundsFlag.size()) > 0) {
+      numRounds = atoi(argv[i] + kRoundsFlag.size());
+    } else {
+      cerr << "Usage: " << argv[0] << " [" << kRoundsFlag << "<n>]" << endl;
+      return kUnrecognizedFlag;
+    }
+  }
+
+  imdb db(kIMDBDataDirectory);
+  if (!db.good()) {
+    cerr << "Data directory not found!  Aborting..." << endl;
+    return kDatabaseNotFound;
+  }
+
+  // copy the keys out so that neither strategy benefits from the other's page faults
+  vector<string> players;
+  for (int i = 0; i < db.getNumPlayers(); i++) players.push_back(db.getPlayer(db.getPlayerOffset(i)));
+  vector<film> films;
+  for (int i = 0; i < db.getNumFilms(); i++) films.push_back(db.getFilm(db.getFilmOffset(i)));
+  mt19937 generator(110);
+  shuffle(players.begin(), players.end(), generator);
+  shuffle(films.begin(), films.end(), generator);
+
+  long searchSum, hashSum = 0;
+  double searchTime = timeLookups(players, numRounds, [&db](const string& player) {
+    return db.searchPlayers(player);
+  }, searchSum);
+  double hashTime = timeLookups(players, numRounds, [&db](const string& player) {
+    return db.findPlayer(player);
+  }, hashSum);
+  report("Actors", players.size(), searchTime, hashTime, db.hasNameIndex());
+  if (searchSum != hashSum) {
+    cerr << "Actor lookups disagree!" << endl;
+    return kLookupMismatch;
+  }
+
+  searchTime = timeLookups(films, numRounds, [&db](const film& movie) {
+    return db.searchFilms(movie);
+  }, searchSum);
+  hashTime = timeLookups(films, numRounds, [&db](const film& movie) {
+    return db.findFilm(movie);
+  }, hashSum);
+  report("Films", films.size(), searchTime, hashTime, db.hasNameIndex());
+  if (searchSum != hashSum) {
+    cerr << "Film lookups disagree!" << endl;
+    return kLookupMismatch;
+  }
+  return 0;
+}
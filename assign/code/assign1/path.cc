@@ -59,7 +59,7 @@ ostream& operator<<(ostream& os, const path& p) {
   
   os << p.startPlayer << " was in ";
   for (int i = 0; i < (int) p.links.size(); i++) {
-    os << "\"" << p.links[i].movie.title << "\" (" << p.links[i].movie.year << ") with " 
+    os << "\"" << p.links[i].movie.title << "\" (" << 1900 + p.links[i].movie.year << ") with " 
        << p.links[i].player << "." << endl;
     if (i + 1 == (int) p.links.size()) break;
     os << p.links[i].player << " was in ";
@@ -0,0 +1,196 @@
+/**
+ * File: search-engines.cc
+ * -----------------------
+ * Presents the implementation of the shortest-path engines exported
+ * by search-engines.h.
+ */
+
+#include <list>
+#include <set>
+#include <unordered_map>
+#include <vector>
+#include "search-engines.h"
+using namespace std;
+
+bool forwardSearch(const imdb& db, const string& source, const string& target, path& result) {
+  list<pair<string, short>> queue;
+  unordered_map<string, pair<film, string>> ancestor;
+  set<string> seenActors;
+  set<film> seenFilms;
+
+  queue.push_back({source, 0});
+  bool found = false;
+
+  while (!queue.empty()) {
+    pair<string, short> frontPair = queue.front();
+    const string& front = frontPair.first;
+    const short chainLength = frontPair.second;
+
+    if (chainLength >= kMaxDegreesOfSeparation) break;
+
+    queue.pop_front();
+    seenActors.insert(front);
+
+    vector<film> films;
+    db.getCredits(front, films);
+
+    for (const film& f: films) {
+      if (seenFilms.find(f) != seenFilms.end()) continue;
+      seenFilms.insert(f);
+      vector<string> cast;
+      db.getCast(f, cast);
+      for (const string& p: cast) {
+        if (seenActors.find(p) != seenActors.end()) continue;
+        seenActors.insert(p);
+        ancestor[p] = {f, front};
+        queue.push_back({p, chainLength + 1});
+        if (p == target) {
+          found = true;
+          break;
+        }
+      }
+      if (found) break;
+    }
+    if (found) break;
+  }
+
+  if (!found) return false;
+
+  list<pair<film, string>> links;
+  string currentActor = target;
+  while (currentActor != source) {
+    links.push_front({ancestor[currentActor].first, currentActor});
+    currentActor = ancestor[currentActor].second;
+  }
+
+  for (const pair<film, string>& link: links)
+    result.addConnection(link.first, link.second);
+  return true;
+}
+
+namespace {
+
+/**
+ * Types: searchLink, searchSide
+ * -----------------------------
+ * Bundles everything one half of a bidirectional search needs to know.
+ * Every actor discovered from this side's root maps to the film and the
+ * actor that lead one step back toward the root, along with its distance
+ * from that root.  The root itself is recorded with a distance of 0.
+ */
+struct searchLink {
+  film movie;
+  string neighbor;
+  int depth;
+};
+
+struct searchSide {
+  unordered_map<string, searchLink> links;
+  set<film> seenFilms;
+  vector<string> frontier;
+  int depth;
+
+  searchSide(const string& root) : frontier(1, root), depth(0) {
+    links[root] = {film(), root, 0};
+  }
+};
+
+}
+
+/**
+ * Function: expandLevel
+ * ---------------------
+ * Expands every actor in side's frontier by one hop.  As soon as a newly
+ * discovered actor turns out to have been discovered by the other side as
+ * well, that actor is surfaced via meet and true is returned.  Because both
+ * sides grow a level at a time and meets are checked on every discovery,
+ * the first meet is guaranteed to lie on a shortest path.
+ */
+static bool expandLevel(const imdb& db, searchSide& side, const searchSide& other, string& meet) {
+  vector<string> next;
+  for (const string& actor: side.frontier) {
+    vector<film> films;
+    db.getCredits(actor, films);
+    for (const film& f: films) {
+      if (!side.seenFilms.insert(f).second) continue;
+      vector<string> cast;
+      db.getCast(f, cast);
+      for (const string& p: cast) {
+        if (side.links.find(p) != side.links.end()) continue;
+        side.links[p] = {f, actor, side.depth + 1};
+        if (other.links.find(p) != other.links.end()) {
+          meet = p;
+          return true;
+        }
+        next.push_back(p);
+      }
+    }
+  }
+
+  side.frontier.swap(next);
+  side.depth++;
+  return false;
+}
+
+bool bidirectionalSearch(const imdb& db, const string& source, const string& target, path& result) {
+  if (source == target) return false; // forwardSearch never connects an actor to themselves either
+  searchSide fromSource(source), fromTarget(target);
+  string meet;
+  bool found = false;
+  while (!found && fromSource.depth + fromTarget.depth < kMaxDegreesOfSeparation &&
+         !fromSource.frontier.empty() && !fromTarget.frontier.empty()) {
+    if (fromSource.frontier.size() <= fromTarget.frontier.size()) {
+      found = expandLevel(db, fromSource, fromTarget, meet);
+    } else {
+      found = expandLevel(db, fromTarget, fromSource, meet);
+    }
+  }
+
+  if (!found) return false;
+
+  list<pair<film, string>> links;
+  for (string actor = meet; actor != source; actor = fromSource.links[actor].neighbor)
+    links.push_front({fromSource.links[actor].movie, actor});
+  for (string actor = meet; actor != target; actor = fromTarget.links[actor].neighbor)
+    links.push_back({fromTarget.links[actor].movie, fromTarget.links[actor].neighbor});
+
+  for (const pair<film, string>& link: links)
+    result.addConnection(link.first, link.second);
+  return true;
+}
+
+/**
+ * Function: addLinks
+ * ------------------
+ * Materializes the names behind the (film id, actor id) links produced by
+ * one of the graph searches and appends them to result.
+ */
+static void addLinks(const graph& g, const vector<pair<uint32_t, uint32_t>>& links, path& result) {
+  for (const pair<uint32_t, uint32_t>& link: links)
+    result.addConnection(g.getFilm(link.first), g.getPlayer(link.second));
+}
+
+bool graphSearch(const graph& g, const string& source, const string& target, path& result,
+                 const yearRange& years) {
+  int sourceID = g.findActor(source);
+  int targetID = g.findActor(target);
+  if (sourceID < 0 || targetID < 0) return false;
+
+  vector<pair<uint32_t, uint32_t>> links;
+  if (!g.findShortestPath(sourceID, targetID, kMaxDegreesOfSeparation, links, years)) return false;
+  addLinks(g, links, result);
+  return true;
+}
+
+bool parallelGraphSearch(const graph& g, const string& source, const string& target,
+                         size_t numThreads, path& result, const yearRange& years) {
+  int sourceID = g.findActor(source);
+  int targetID = g.findActor(target);
+  if (sourceID < 0 || targetID < 0) return false;
+
+  vector<pair<uint32_t, uint32_t>> links;
+  if (!g.findShortestPathInParallel(sourceID, targetID, kMaxDegreesOfSeparation, numThreads, links, years))
+    return false;
+  addLinks(g, links, result);
+  return true;
+}
@@ -0,0 +1,74 @@
+/**
+ * File: search-engines.h
+ * ----------------------
+ * Exports the shortest-path engines used by the search executable to
+ * connect two actors/actresses through a chain of shared films.  Every
+ * engine honors the same six-degrees cutoff and reports its answer
+ * through the path class, so engines can be swapped in and out
+ * without the client noticing anything but a change in speed.
+ */
+
+#pragma once
+#include <string>
+#include "imdb.h"
+#include "graph.h"
+#include "path.h"
+
+/**
+ * Constant: kMaxDegreesOfSeparation
+ * ---------------------------------
+ * The longest chain of films any engine will consider before giving up.
+ */
+static const int kMaxDegreesOfSeparation = 6;
+
+/**
+ * Function: forwardSearch
+ * -----------------------
+ * Runs a classic breadth-first search outward from source, one frontier
+ * at a time, until target is discovered or kMaxDegreesOfSeparation
+ * hops have been explored.
+ *
+ * @param db the imdb being queried.
+ * @param source the actor/actress the path should start from.
+ * @param target the actor/actress the path should end at.
+ * @param result the path to be populated.  It should be a path holding
+ *               just source, and it's left that way if no connection exists.
+ * @return true if and only if a connection was found.
+ */
+bool forwardSearch(const imdb& db, const std::string& source,
+                   const std::string& target, path& result);
+
+/**
+ * Function: bidirectionalSearch
+ * -----------------------------
+ * Meet-in-the-middle variant of forwardSearch.  Two frontiers are grown,
+ * one from source and one from target, and at every step only the smaller
+ * of the two is expanded by a full level.  The search ends as soon as a
+ * level expansion reaches an actor already discovered by the other side,
+ * and the chain joined through that first shared actor is returned.
+ * Parameters and return value are the same as for forwardSearch.
+ */
+bool bidirectionalSearch(const imdb& db, const std::string& source,
+                         const std::string& target, path& result);
+
+/**
+ * Function: graphSearch
+ * ---------------------
+ * Same contract as bidirectionalSearch, except that the search runs over the
+ * integer ids of a prebuilt graph instead of over names pulled from the imdb,
+ * and names are only materialized for the links of the final path.  If a year
+ * range is supplied, only films released within it are used.
+ */
+bool graphSearch(const graph& g, const std::string& source,
+                 const std::string& target, path& result,
+                 const yearRange& years = kAllYears);
+
+/**
+ * Function: parallelGraphSearch
+ * -----------------------------
+ * Same as graphSearch, except that each level of the search is expanded by
+ * numThreads worker threads.  See graph::findShortestPathInParallel.
+ */
+bool parallelGraphSearch(const graph& g, const std::string& source,
+                         const std::string& target, size_t numThreads, path& result,
+                         const yearRange& years = kAllYears);
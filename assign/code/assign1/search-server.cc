@@ -0,0 +1,306 @@
+/**
+ * File: search-server.cc
+ * ----------------------
+ * Presents the implementation of a long-running six-degrees query service.
+ * The imdb is mapped and the graph index is built exactly once at startup,
+ * after which any number of queries are answered concurrently by a pool of
+ * worker threads, all sharing the same read-only imdb and graph.
+ *
+ * Queries are read one per line, either from standard input (the default)
+ * or from clients connecting to a local Unix domain socket (--socket=<path>)
+ * or to a TCP port bound to the loopback interface (--port=<n>).  Each line
+ * must contain two names separated by a tab:
+ *
+ *     Kevin Bacon<TAB>Meryl Streep
+ *
+ * Replies are written back in blocks, possibly out of order, each introduced
+ * by a header line identifying the query and its latency, followed by exactly
+ * what the search executable would print, followed by a blank line:
+ *
+ *     Query 1: Kevin Bacon -> Meryl Streep (answered in 0.42 ms, search took 0.31 ms)
+ *     Kevin Bacon was in "The River Wild" (1994) with Meryl Streep.
+ *
+ * The latency covers everything from the moment the query was read until its
+ * reply was ready, so it includes any time spent waiting for a free worker.
+ */
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <ext/stdio_filebuf.h>
+#include "imdb.h"
+#include "graph.h"
+#include "path.h"
+#include "search-engines.h"
+#include "thread-pool.h"
+
+using namespace std;
+using namespace __gnu_cxx; // __gnu_cxx::stdio_filebuf -> stdio_filebuf
+
+static const int kDatabaseNotFound = 2;
+static const int kUnrecognizedFlag = 3;
+static const int kServerSocketFailure = 4;
+static const int kBacklog = 128;
+static const long kMaxPort = 65535;
+
+static const string kThreadsFlag = "--threads=";
+static const string kSocketFlag = "--socket=";
+static const string kPortFlag = "--port=";
+
+/**
+ * Type: client
+ * ------------
+ * Where replies for one source of queries are written.  Every outstanding
+ * query holds a shared_ptr to its client, so a connection's descriptor is
+ * closed only once the last of its replies has been written.  The mutex
+ * keeps replies to the same client from interleaving.
+ */
+struct client {
+  int fd;
+  bool ownsDescriptor;
+  mutex m;
+
+  client(int fd, bool ownsDescriptor) : fd(fd), ownsDescriptor(ownsDescriptor) {}
+  ~client() { if (ownsDescriptor) close(fd); }
+};
+
+/**
+ * Function: writeReply
+ * --------------------
+ * Writes the entire reply to the client in one critical section, giving up
+ * silently if the client has gone away.
+ */
+static void writeReply(client& c, const string& reply) {
+  lock_guard<mutex> lg(c.m);
+  size_t written = 0;
+  while (written < reply.size()) {
+    ssize_t count = write(c.fd, reply.c_str() + written, reply.size() - written);
+    if (count <= 0) return;
+    written += count;
+  }
+}
+
+static double millisecondsSince(const chrono::steady_clock::time_point& start) {
+  return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Function: answerQuery
+ * ---------------------
+ * Runs on a worker thread.  Parses one query line, searches the shared graph,
+ * and writes the reply block described in the file header.
+ */
+static void answerQuery(const graph& g, const string& line, size_t queryNumber,
+                        const chrono::steady_clock::time_point& received, client& c) {
+  ostringstream reply;
+  size_t tab = line.find('\t');
+  if (tab == string::npos) {
+    reply << "Query " << queryNumber << ": malformed (expected <actor1><TAB><actor2>)" << endl << endl;
+    writeReply(c, reply.str());
+    return;
+  }
+
+  string source = line.substr(0, tab), dest = line.substr(tab + 1);
+  path result(source);
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  bool found = graphSearch(g, source, dest, result);
+  double searchTime = millisecondsSince(start);
+  reply << "Query " << queryNumber << ": " << source << " -> " << dest
+        << " (answered in " << millisecondsSince(received) << " ms, search took "
+        << searchTime << " ms)" << endl;
+  if (found) {
+    reply << result;
+  } else {
+    reply << "No connection found between " << source << " and " << dest << "." << endl;
+  }
+  reply << endl;
+  writeReply(c, reply.str());
+}
+
+/**
+ * Function: serveQueries
+ * ----------------------
+ * Reads queries from the supplied stream until it's exhausted, handing each one
+ * off to the thread pool.  Blank lines are ignored.
+ */
+static void serveQueries(const graph& g, ThreadPool& pool, istream& is, const shared_ptr<client>& c) {
+  size_t queryNumber = 0;
+  while (true) {
+    string line;
+    getline(is, line);
+    if (is.fail()) break;
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line.empty()) continue;
+    chrono::steady_clock::time_point received = chrono::steady_clock::now();
+    queryNumber++;
+    pool.schedule([&g, line, queryNumber, received, c] {
+      answerQuery(g, line, queryNumber, received, *c);
+    });
+  }
+}
+
+/**
+ * Function: closeAndFail
+ * ----------------------
+ * Closes s and returns -1, leaving errno as the call that failed set it.
+ */
+static int closeAndFail(int s) {
+  int err = errno;
+  close(s);
+  errno = err;
+  return -1;
+}
+
+/**
+ * Function: createServerSocket
+ * ----------------------------
+ * Creates, binds, and starts listening on either a Unix domain socket at the
+ * specified path or a TCP socket bound to 127.0.0.1 on the specified port.
+ * Returns the listening descriptor, or -1 on failure, with errno set to say why.
+ */
+static int createServerSocket(const string& socketPath, int port) {
+  int s;
+  if (!socketPath.empty()) {
+    struct sockaddr_un address;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+      errno = ENAMETOOLONG;
+      return -1;
+    }
+    s = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (s < 0) return -1;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socketPath.c_str());
+    unlink(socketPath.c_str());
+    if (bind(s, (struct sockaddr *) &address, sizeof(address)) < 0) return closeAndFail(s);
+  } else {
+    s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s < 0) return -1;
+    const int optval = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval));
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (bind(s, (struct sockaddr *) &address, sizeof(address)) < 0) return closeAndFail(s);
+  }
+
+  if (listen(s, kBacklog) < 0) return closeAndFail(s);
+  return s;
+}
+
+/**
+ * Function: acceptClients
+ * -----------------------
+ * Accepts connections forever.  Every connection gets its own lightweight
+ * reader thread, but all of the actual searching happens on the shared pool.
+ */
+static void acceptClients(const graph& g, ThreadPool& pool, int server) {
+  while (true) {
+    int fd = accept(server, NULL, NULL);
+    if (fd < 0) continue;
+    int infd = dup(fd);  // the filebuf closes its own descriptor, and replies still need fd
+    if (infd < 0) {
+      close(fd);  // out of descriptors, so turn this client away
+      continue;
+    }
+    shared_ptr<client> c(new client(fd, /* ownsDescriptor = */ true));
+    thread([&g, &pool, c, infd] {
+      stdio_filebuf<char> inbuf(infd, ios::in);
+      istream is(&inbuf);
+      serveQueries(g, pool, is, c);
+    }).detach();
+  }
+}
+
+/**
+ * Function: parsePort
+ * -------------------
+ * Parses the argument of --port, which must be a TCP port number from 1 through
+ * 65535 and nothing else.  Returns false, leaving port alone, if it isn't.
+ */
+static bool parsePort(const char *text, int& port) {
+  char *end;
+  errno = 0;
+  long value = strtol(text, &end, 10);
+  if (end == text || *end != '\0' || errno == ERANGE || value < 1 || value > kMaxPort) return false;
+  port = value;
+  return true;
+}
+
+static void printUsage(const char *progname) {
+  cerr << "Usage: " << progname << " [" << kThreadsFlag << "<n>] ["
+       << kSocketFlag << "<path> | " << kPortFlag << "<n>]" << endl;
+}
+
+int main(int argc, char *argv[]) {
+  size_t numThreads = thread::hardware_concurrency();
+  if (numThreads == 0) numThreads = 1;
+  string socketPath;
+  int port = 0;
+  for (int i = 1; i < argc; i++) {
+    const string flag = argv[i];
+    if (flag.compare(0, kThreadsFlag.size(), kThreadsFlag) == 0 && atoi(argv[i] + kThreadsFlag.size()) > 0) {
+      numThreads = atoi(argv[i] + kThreadsFlag.size());
+    } else if (flag.compare(0, kSocketFlag.size(), kSocketFlag) == 0 && flag.size() > kSocketFlag.size()) {
+      socketPath = flag.substr(kSocketFlag.size());
+    } else if (flag.compare(0, kPortFlag.size(), kPortFlag) == 0 && parsePort(argv[i] + kPortFlag.size(), port)) {
+      // port has been set
+    } else {
+      cerr << argv[0] << ": Unrecognized flag (" << flag << ")" << endl;
+      printUsage(argv[0]);
+      return kUnrecognizedFlag;
+    }
+  }
+
+  if (!socketPath.empty() && port > 0) {
+    printUsage(argv[0]);
+    return kUnrecognizedFlag;
+  }
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  imdb db(kIMDBDataDirectory);
+  if (!db.good()) {
+    cerr << "Data directory not found!  Aborting..." << endl;
+    return kDatabaseNotFound;
+  }
+
+  graph g(db);
+  cerr << "Loaded " << g.getNumActors() << " actors and " << g.getNumFilms() << " films in "
+       << millisecondsSince(start) << " ms; answering queries on " << numThreads << " threads." << endl;
+
+  signal(SIGPIPE, SIG_IGN); // clients that hang up early shouldn't bring down the server
+  ThreadPool pool(numThreads);
+  if (socketPath.empty() && port == 0) {
+    shared_ptr<client> c(new client(STDOUT_FILENO, /* ownsDescriptor = */ false));
+    serveQueries(g, pool, cin, c);
+    pool.wait();
+    return 0;
+  }
+
+  int server = createServerSocket(socketPath, port);
+  if (server < 0) {
+    int err = errno;
+    cerr << "Could not listen on " << (socketPath.empty() ? "port " + to_string(port) : socketPath)
+         << ": " << strerror(err) << endl;
+    return kServerSocketFailure;
+  }
+
+  cerr << "Listening on " << (socketPath.empty() ? "127.0.0.1:" + to_string(port) : socketPath) << "." << endl;
+  acceptClients(g, pool, server);
+  return 0;
+}
@@ -1,18 +1,192 @@
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
-#include <list>
-#include <unordered_map>
-#include <set>
-#include <vector>
+#include <string>
 #include "imdb.h"
+#include "graph.h"
+#include "fuzzy-index.h"
+#include "landmarks.h"
+#include "path.h"
+#include "search-engines.h"
 
 using namespace std;
 
 static const int kWrongArgumentCount = 1;
 static const int kDatabaseNotFound = 2;
+static const int kUnrecognizedFlag = 3;
+
+static const string kEngineFlag = "--engine=";
+static const string kThreadsFlag = "--threads=";
+static const string kTimingFlag = "--timing";
+static const string kDistanceFlag = "--distance";
+static const string kYearsFlag = "--years=";
+static const string kForwardEngine = "forward";
+static const string kBidirectionalEngine = "bidirectional";
+static const string kGraphEngine = "graph";
+static const int kSuggestionMaxEdits = 2;
+static const size_t kMaxSuggestions = 5;
+
+static void printUsage(const char *progname) {
+    cerr << "Usage: " << progname << " [" << kEngineFlag << kForwardEngine << "|"
+         << kBidirectionalEngine << "|" << kGraphEngine << "] [" << kThreadsFlag << "<n>] ["
+         << kTimingFlag << "] [" << kDistanceFlag << "] [" << kYearsFlag << "[<first>]-[<last>]] <actor1> <actor2>" << endl;
+}
+
+/**
+ * Function: parseYearRange
+ * ------------------------
+ * Parses the argument of --years, which is a range of release years such as
+ * 1980-1999, 1980- (1980 onward), or -1979 (up through 1979).  Returns false
+ * if the text isn't of that form.
+ */
+static bool parseYearRange(const string& text, yearRange& years) {
+    size_t dash = text.find('-');
+    if (dash == string::npos || text.size() == 1) return false;
+    years = kAllYears;
+    char *end;
+    if (dash > 0) {
+        years.first = strtol(text.c_str(), &end, 10);
+        if (end != text.c_str() + dash) return false;
+    }
+    if (dash < text.size() - 1) {
+        years.last = strtol(text.c_str() + dash + 1, &end, 10);
+        if (*end != '\0') return false;
+    }
+    return years.first <= years.last;
+}
+
+/**
+ * Function: processCommandLineFlags
+ * ---------------------------------
+ * Consumes all leading flags, updating engine, numThreads, timing, distance, and years
+ * accordingly, and returns the index of the first non-flag argument, or -1 if a flag isn't
+ * recognized.  --threads and --years only make sense for the graph engine, so they select that
+ * engine unless some other one was explicitly asked for (which is an error).
+ */
+static int processCommandLineFlags(int argc, char *argv[], string& engine, size_t& numThreads,
+                                   bool& timing, bool& distance, yearRange& years) {
+    bool engineSpecified = false;
+    int argIndex = 1;
+    for (; argIndex < argc && string(argv[argIndex]).compare(0, 2, "--") == 0; argIndex++) {
+        const string flag = argv[argIndex];
+        if (flag.compare(0, kEngineFlag.size(), kEngineFlag) == 0) {
+            engine = flag.substr(kEngineFlag.size());
+            engineSpecified = true;
+            if (engine != kForwardEngine && engine != kBidirectionalEngine && engine != kGraphEngine) return -1;
+        } else if (flag.compare(0, kThreadsFlag.size(), kThreadsFlag) == 0) {
+            int value = atoi(flag.c_str() + kThreadsFlag.size());
+            if (value <= 0) return -1;
+            numThreads = value;
+        } else if (flag == kTimingFlag) {
+            timing = true;
+        } else if (flag == kDistanceFlag) {
+            distance = true;
+        } else if (flag.compare(0, kYearsFlag.size(), kYearsFlag) == 0) {
+            if (!parseYearRange(flag.substr(kYearsFlag.size()), years)) return -1;
+        } else {
+            return -1;
+        }
+    }
+
+    if (numThreads > 0 || !years.includesAll()) {
+        if (engineSpecified && engine != kGraphEngine) return -1;
+        engine = kGraphEngine;
+    }
+    return argIndex;
+}
+
+/**
+ * Function: millisecondsSince
+ * ---------------------------
+ * Self-explanatory.
+ */
+static double millisecondsSince(const chrono::steady_clock::time_point& start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Function: suggestAlternatives
+ * -----------------------------
+ * For each of the two names that isn't in the database, prints the closest
+ * actual names to standard error, provided the trigram index has been built
+ * (see build-fuzzy-index).  Standard output is left untouched.
+ */
+static void suggestAlternatives(const imdb& db, const string& source, const string& dest) {
+    fuzzyIndex index(kIMDBDataDirectory, db);
+    if (!index.good()) return;
+    for (const string& name: {source, dest}) {
+        if (db.findPlayer(name) >= 0) continue;
+        vector<fuzzyIndex::match> matches = index.findSimilar(name, kSuggestionMaxEdits, kMaxSuggestions);
+        if (matches.empty()) continue;
+        cerr << name << " isn't in the database.  Did you mean:" << endl;
+        for (const fuzzyIndex::match& m: matches) cerr << "    " << db.getPlayerView(m.offset) << endl;
+    }
+}
+
+/**
+ * Function: printDistance
+ * -----------------------
+ * Implements --distance: reports only how many degrees apart the two actors
+ * are, consulting the landmark index (see build-landmarks) when one has been
+ * built for this imdb, and otherwise falling back on a graph search.  The
+ * graph is only built if the landmark bounds don't settle the question on
+ * their own.  The landmarks know nothing of release years, so they're ignored
+ * when the search is restricted to a range of years.
+ */
+static void printDistance(const imdb& db, const string& source, const string& dest, bool timing,
+                          const yearRange& years) {
+    landmarkIndex index(kIMDBDataDirectory, db);
+    bool useIndex = index.good() && years.includesAll();
+
+    int distance = -1;
+    bool proven = false;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    int s = db.findPlayer(source), t = db.findPlayer(dest);
+    if (s >= 0 && t >= 0 && s != t) {
+        if (useIndex) proven = index.getProvenDistance(s, t, kMaxDegreesOfSeparation, distance);
+        if (!proven) {
+            chrono::steady_clock::time_point graphStart = chrono::steady_clock::now();
+            graph g(db);
+            if (timing) cerr << "Graph built in " << millisecondsSince(graphStart) << " ms." << endl;
+            vector<pair<uint32_t, uint32_t>> links;
+            if (useIndex) {
+                distance = index.getDistance(g, s, t, kMaxDegreesOfSeparation);
+            } else if (g.findShortestPath(s, t, kMaxDegreesOfSeparation, links, years)) {
+                distance = links.size();
+            }
+        }
+    }
+    if (timing) {
+        cerr << "Distance (";
+        if (!years.includesAll()) cerr << "year-filtered graph search";
+        else if (!index.good()) cerr << "no landmark index";
+        else cerr << index.getNumLandmarks() << " landmarks, " << (proven ? "proven by bounds" : "bounded search");
+        cerr << ") took " << millisecondsSince(start) << " ms." << endl;
+    }
+
+    if (distance < 0) {
+        cout << "No connection found between " << source << " and " << dest << "." << endl;
+        suggestAlternatives(db, source, dest);
+    } else {
+        cout << source << " and " << dest << " are " << distance
+             << (distance == 1 ? " degree" : " degrees") << " apart." << endl;
+    }
+}
 
 int main(int argc, char *argv[]) {
-    if (argc != 3) {
-        cerr << "Usage: " << argv[0] << " <actor1> <actor2>" << endl;
+    string engine = kBidirectionalEngine;
+    size_t numThreads = 0;
+    bool timing = false, distance = false;
+    yearRange years = kAllYears;
+    int argIndex = processCommandLineFlags(argc, argv, engine, numThreads, timing, distance, years);
+    if (argIndex < 0) {
+        cerr << argv[0] << ": Unrecognized or conflicting flags." << endl;
+        printUsage(argv[0]);
+        return kUnrecognizedFlag;
+    }
+
+    if (argc - argIndex != 2) {
+        printUsage(argv[0]);
         return kWrongArgumentCount;
     }
 
@@ -22,70 +196,40 @@ int main(int argc, char *argv[]) {
         return kDatabaseNotFound;
     }
 
-    string source(argv[1]), dest(argv[2]);
-    list<pair<string, short>> queue;
-    unordered_map<string, pair<film, string>> ancestor;
-    set<string> seenActors;
-    set<film> seenFilms;
-
-    queue.push_back({source, 0});
-    bool found = false;
-
-    while (!queue.empty()) {
-        pair<string, short> frontPair = queue.front();
-        const string& front = frontPair.first;
-        const short chainLength = frontPair.second;
-
-        if (chainLength >= 6) break;
-
-        queue.pop_front();
-        seenActors.insert(front);
-
-        vector<film> films;
-        db.getCredits(front, films);
-
-        for (const film& f: films) {
-            if (seenFilms.find(f) != seenFilms.end()) continue;
-            seenFilms.insert(f);
-            vector<string> cast;
-            db.getCast(f, cast);
-            for (const string& p: cast) {
-                if (seenActors.find(p) != seenActors.end()) continue;
-                seenActors.insert(p);
-                ancestor[p] = {f, front};
-                queue.push_back({p, chainLength + 1});
-                if (p == dest) {
-                    found = true;
-                    break;
-                }
-            }
-            if (found) break;
-        }
-        if (found) break;
+    string source(argv[argIndex]), dest(argv[argIndex + 1]);
+    if (distance) {
+        printDistance(db, source, dest, timing, years);
+        return 0;
+    }
+
+    path result(source);
+    bool found;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    if (engine == kForwardEngine) {
+        found = forwardSearch(db, source, dest, result);
+    } else if (engine == kGraphEngine) {
+        graph g(db);
+        if (timing) cerr << "Graph built in " << millisecondsSince(start) << " ms." << endl;
+        start = chrono::steady_clock::now();
+        found = (numThreads > 0)
+            ? parallelGraphSearch(g, source, dest, numThreads, result, years)
+            : graphSearch(g, source, dest, result, years);
+    } else {
+        found = bidirectionalSearch(db, source, dest, result);
+    }
+    if (timing) {
+        cerr << "Search (" << engine << " engine";
+        if (numThreads > 0) cerr << ", " << numThreads << " threads";
+        cerr << ") took " << millisecondsSince(start) << " ms." << endl;
     }
 
     if (!found) {
         cout << "No connection found between "
              << source << " and " << dest << "." << endl;
+        suggestAlternatives(db, source, dest);
         return 0;
     }
 
-    list<pair<film, string>> path;
-    string currentActor = dest;
-    while (currentActor != source) {
-        path.push_front({ancestor[currentActor].first, currentActor});
-        currentActor = ancestor[currentActor].second;
-    }
-
-    currentActor = source;
-    for (const pair<film, string>& p: path) {
-        cout << currentActor
-             << " was in \"" << p.first.title << "\" ("
-             << 1900 + p.first.year
-             << ") with " << p.second
-             << "." << endl;
-        currentActor = p.second;
-    }
-
+    cout << result;
     return 0;
 }
@@ -0,0 +1,54 @@
+/**
+ * File: thread-pool.cc
+ * --------------------
+ * Presents the implementation of the ThreadPool class.
+ */
+
+#include "thread-pool.h"
+using namespace std;
+
+ThreadPool::ThreadPool(size_t numThreads) {
+  for (size_t i = 0; i < numThreads; i++) {
+    workers.push_back(thread([this] { worker(); }));
+  }
+}
+
+void ThreadPool::worker() {
+  while (true) {
+    Thunk thunk;
+    {
+      lock_guard<mutex> lg(m);
+      jobAvailable.wait(m, [this] { return shouldTerminate || !jobs.empty(); });
+      if (jobs.empty()) return; // only possible when shutting down
+      thunk = jobs.front();
+      jobs.pop();
+    }
+
+    thunk();
+
+    lock_guard<mutex> lg(m);
+    if (--outstanding == 0) allDone.notify_all();
+  }
+}
+
+void ThreadPool::schedule(const Thunk& thunk) {
+  lock_guard<mutex> lg(m);
+  jobs.push(thunk);
+  outstanding++;
+  jobAvailable.notify_one();
+}
+
+void ThreadPool::wait() {
+  lock_guard<mutex> lg(m);
+  allDone.wait(m, [this] { return outstanding == 0; });
+}
+
+ThreadPool::~ThreadPool() {
+  wait();
+  {
+    lock_guard<mutex> lg(m);
+    shouldTerminate = true;
+    jobAvailable.notify_all();
+  }
+  for (thread& t: workers) t.join();
+}
@@ -0,0 +1,63 @@
+/**
+ * File: thread-pool.h
+ * -------------------
+ * This class defines the ThreadPool class, which accepts a collection
+ * of thunks (which are zero-argument functions that don't return a value)
+ * and schedules them in a FIFO manner to be executed by a constant number
+ * of worker threads that exist solely to invoke previously scheduled thunks.
+ * The interface mirrors the ThreadPool built for the news aggregator, but
+ * the implementation is a plain job queue without a dispatcher thread.
+ */
+
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+typedef std::function<void(void)> Thunk;
+
+class ThreadPool {
+ public:
+
+/**
+ * Constructs a ThreadPool configured to spawn up to the specified
+ * number of threads.
+ */
+  ThreadPool(size_t numThreads);
+
+/**
+ * Schedules the provided thunk to be executed by one of the ThreadPool's
+ * threads as soon as all previously scheduled thunks have been handled.
+ */
+  void schedule(const Thunk& thunk);
+
+/**
+ * Blocks and waits until all previously scheduled thunks
+ * have been executed in full.
+ */
+  void wait();
+
+/**
+ * Waits for all previously scheduled thunks to execute, and then
+ * brings down the worker threads.
+ */
+  ~ThreadPool();
+
+ private:
+  std::vector<std::thread> workers;
+  std::mutex m;
+  std::condition_variable_any jobAvailable;  // signaled when a job is queued or on shutdown
+  std::condition_variable_any allDone;       // signaled when the last outstanding job finishes
+  std::queue<Thunk> jobs;
+  size_t outstanding = 0;                    // jobs queued or currently executing
+  bool shouldTerminate = false;
+
+  void worker();
+
+  ThreadPool(const ThreadPool& original) = delete;
+  ThreadPool& operator=(const ThreadPool& rhs) = delete;
+};
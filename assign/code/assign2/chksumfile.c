@@ -13,6 +13,9 @@
 #include "chksumfile.h"
 #include <openssl/sha.h>
 
+// How much of a file is read at a time when the image isn't memory-mapped.
+#define CHKSUM_CHUNK_SIZE (64 * 1024)
+
 int chksumfile_byinumber(struct unixfilesystem *fs, int inumber, void *chksum) {
   SHA_CTX shactx;
   if (!SHA1_Init(&shactx)) {
@@ -32,16 +35,30 @@ int chksumfile_byinumber(struct unixfilesystem *fs, int inumber, void *chksum) {
   }
 
   int size = inode_getsize(&in);
-  for (int offset = 0; offset < size; offset += DISKIMG_SECTOR_SIZE) {
-    char buf[DISKIMG_SECTOR_SIZE];
-    int bno = offset/DISKIMG_SECTOR_SIZE;
+  if (fs->image != NULL) {
+    // The blocks are already in memory, so hash them where they lie.
+    for (int offset = 0; offset < size; offset += DISKIMG_SECTOR_SIZE) {
+      const void *buf;
+      int bno = offset/DISKIMG_SECTOR_SIZE;
+
+      int bytesMoved = file_getblockptr(fs, inumber, bno, &buf);
+      if (bytesMoved < 0)
+        return -1;
 
-    int bytesMoved = file_getblock(fs, inumber, bno, buf);
-    if (bytesMoved < 0)
-      return -1;
+      if (!SHA1_Update(&shactx, buf, bytesMoved))
+        return -1;
+    }
+  } else {
+    // Read big chunks so that contiguous blocks come off the disk together.
+    char buf[CHKSUM_CHUNK_SIZE];
+    for (int offset = 0; offset < size; offset += CHKSUM_CHUNK_SIZE) {
+      int bytesMoved = file_read(fs, inumber, offset, CHKSUM_CHUNK_SIZE, buf);
+      if (bytesMoved <= 0)
+        return -1;
 
-    if (!SHA1_Update(&shactx, buf, bytesMoved))
-      return -1;
+      if (!SHA1_Update(&shactx, buf, bytesMoved))
+        return -1;
+    }
   }
 
   if (!SHA1_Final(chksum, &shactx))
@@ -0,0 +1,137 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dentrycache.h"
+
+#define NAME_SIZE sizeof(((struct direntv6 *) 0)->d_name)
+#define NUM_INUMBERS 65536  // inumbers are 16 bits wide
+#define INITIAL_BUCKETS 1024
+#define NO_ENTRY -1
+
+struct entry {
+  int dirinumber;
+  struct direntv6 dirent;
+  int next;  // next entry in the same bucket
+};
+
+struct dentrycache {
+  int numEntries;
+  int maxEntries;
+  int numBuckets;  // a power of two, kept at least as large as maxEntries
+  int *buckets;
+  struct entry *entries;
+  uint8_t complete[NUM_INUMBERS / 8];  // one bit per directory recorded in full
+};
+
+/**
+ * Directory entry names are padded with NULs but needn't be NUL-terminated
+ * when they're a full NAME_SIZE characters long, so names are hashed and
+ * compared up to the first NUL or NAME_SIZE characters, whichever comes first.
+ */
+static uint32_t hashof(int dirinumber, const char *name) {
+  uint32_t hash = 2166136261u ^ (uint32_t) dirinumber;
+  hash *= 16777619u;
+  for (size_t i = 0; i < NAME_SIZE && name[i] != '\0'; i++) {
+    hash ^= (unsigned char) name[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static int samename(const char *name, const char *d_name) {
+  return strncmp(name, d_name, NAME_SIZE) == 0;
+}
+
+struct dentrycache *dentrycache_init(void) {
+  struct dentrycache *cache = calloc(1, sizeof(struct dentrycache));
+  if (cache == NULL) return NULL;
+  cache->maxEntries = cache->numBuckets = INITIAL_BUCKETS;
+  cache->buckets = malloc(cache->numBuckets * sizeof(int));
+  cache->entries = malloc(cache->maxEntries * sizeof(struct entry));
+  if (cache->buckets == NULL || cache->entries == NULL) {
+    dentrycache_free(cache);
+    return NULL;
+  }
+  for (int b = 0; b < cache->numBuckets; b++) cache->buckets[b] = NO_ENTRY;
+  return cache;
+}
+
+static int iscomplete(const struct dentrycache *cache, int dirinumber) {
+  return (cache->complete[dirinumber / 8] >> (dirinumber % 8)) & 1;
+}
+
+int dentrycache_lookup(struct dentrycache *cache, int dirinumber, const char *name,
+                       struct direntv6 *dirEnt) {
+  if (dirinumber < 0 || dirinumber >= NUM_INUMBERS) return -1;
+  // A name too long to fit in an entry is never cached.
+  if (strlen(name) > NAME_SIZE) return iscomplete(cache, dirinumber) ? 0 : -1;
+  int b = hashof(dirinumber, name) & (cache->numBuckets - 1);
+  for (int e = cache->buckets[b]; e != NO_ENTRY; e = cache->entries[e].next) {
+    const struct entry *entry = &cache->entries[e];
+    if (entry->dirinumber == dirinumber && samename(name, entry->dirent.d_name)) {
+      *dirEnt = entry->dirent;
+      return 1;
+    }
+  }
+  return iscomplete(cache, dirinumber) ? 0 : -1;
+}
+
+/**
+ * Doubles the number of entries the cache can hold, and the number of buckets
+ * along with it.  Returns 0 on success and -1 if memory runs out, in which case
+ * the cache is left as it was.
+ */
+static int grow(struct dentrycache *cache) {
+  int maxEntries = 2 * cache->maxEntries;
+  struct entry *entries = realloc(cache->entries, maxEntries * sizeof(struct entry));
+  if (entries == NULL) return -1;
+  cache->entries = entries;
+  int *buckets = malloc(maxEntries * sizeof(int));
+  if (buckets == NULL) return -1;
+
+  cache->maxEntries = cache->numBuckets = maxEntries;
+  free(cache->buckets);
+  cache->buckets = buckets;
+  for (int b = 0; b < cache->numBuckets; b++) cache->buckets[b] = NO_ENTRY;
+  for (int e = 0; e < cache->numEntries; e++) {
+    struct entry *entry = &cache->entries[e];
+    int b = hashof(entry->dirinumber, entry->dirent.d_name) & (cache->numBuckets - 1);
+    entry->next = cache->buckets[b];
+    cache->buckets[b] = e;
+  }
+  return 0;
+}
+
+int dentrycache_add(struct dentrycache *cache, int dirinumber, const struct direntv6 *dirEnt) {
+  if (dirinumber < 0 || dirinumber >= NUM_INUMBERS) return -1;
+  int b = hashof(dirinumber, dirEnt->d_name) & (cache->numBuckets - 1);
+  for (int e = cache->buckets[b]; e != NO_ENTRY; e = cache->entries[e].next) {
+    const struct entry *entry = &cache->entries[e];
+    // Like directory_findname, keep the first of any entries sharing a name.
+    if (entry->dirinumber == dirinumber && samename(dirEnt->d_name, entry->dirent.d_name)) return 0;
+  }
+
+  if (cache->numEntries == cache->maxEntries) {
+    if (grow(cache) < 0) return -1;
+    b = hashof(dirinumber, dirEnt->d_name) & (cache->numBuckets - 1);
+  }
+  struct entry *entry = &cache->entries[cache->numEntries];
+  entry->dirinumber = dirinumber;
+  entry->dirent = *dirEnt;
+  entry->next = cache->buckets[b];
+  cache->buckets[b] = cache->numEntries++;
+  return 0;
+}
+
+void dentrycache_markcomplete(struct dentrycache *cache, int dirinumber) {
+  if (dirinumber < 0 || dirinumber >= NUM_INUMBERS) return;
+  cache->complete[dirinumber / 8] |= 1 << (dirinumber % 8);
+}
+
+void dentrycache_free(struct dentrycache *cache) {
+  if (cache == NULL) return;
+  free(cache->buckets);
+  free(cache->entries);
+  free(cache);
+}
@@ -0,0 +1,46 @@
+#ifndef _DENTRYCACHE_H_
+#define _DENTRYCACHE_H_
+
+#include "direntv6.h"
+
+/**
+ * A cache of directory entries keyed by (directory inumber, name), so that
+ * resolving a pathname doesn't have to rescan every directory along the way.
+ * Once a directory has been recorded in full, a name missing from the cache
+ * is known to be missing from the directory as well.  The disk image is
+ * assumed not to change while the cache is in use.
+ */
+struct dentrycache;
+
+/**
+ * Allocates an empty cache.  Returns NULL on error.
+ */
+struct dentrycache *dentrycache_init(void);
+
+/**
+ * Looks up the specified name in the specified directory.  Returns 1 and
+ * copies the entry into dirEnt if it's cached, 0 if the directory has been
+ * recorded in full and has no such entry, and -1 if the directory has to be
+ * scanned to find out.
+ */
+int dentrycache_lookup(struct dentrycache *cache, int dirinumber, const char *name,
+                       struct direntv6 *dirEnt);
+
+/**
+ * Records one entry of the specified directory.  Returns 0 on success and -1
+ * if it couldn't be recorded, in which case the directory mustn't be marked
+ * complete.
+ */
+int dentrycache_add(struct dentrycache *cache, int dirinumber, const struct direntv6 *dirEnt);
+
+/**
+ * Notes that every entry of the specified directory has now been recorded.
+ */
+void dentrycache_markcomplete(struct dentrycache *cache, int dirinumber);
+
+/**
+ * Frees the cache.
+ */
+void dentrycache_free(struct dentrycache *cache);
+
+#endif // _DENTRYCACHE_H_
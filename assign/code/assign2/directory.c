@@ -2,12 +2,20 @@
 #include "inode.h"
 #include "diskimg.h"
 #include "file.h"
+#include "dentrycache.h"
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
 
+// Directories with more entries than this are recorded in the dentry cache
+// in full the first time they're scanned, so they're never scanned again.
+#define DIRECTORY_HASH_MIN_ENTRIES (DISKIMG_SECTOR_SIZE / sizeof(struct direntv6))
+
 int directory_findname(struct unixfilesystem *fs, const char *name,
 		       int dirinumber, struct direntv6 *dirEnt) {
+  int cached = dentrycache_lookup(fs->dentries, dirinumber, name, dirEnt);
+  if (cached >= 0) return cached ? 0 : -1;
+
   struct inode in;
   int err = inode_iget(fs, dirinumber, &in);
   if (err < 0) return err;
@@ -18,22 +26,30 @@ int directory_findname(struct unixfilesystem *fs, const char *name,
   int size = inode_getsize(&in);
   assert((size % sizeof(struct direntv6)) == 0);
   int numBlocks  = (size + DISKIMG_SECTOR_SIZE - 1) / DISKIMG_SECTOR_SIZE;
-  char buf[DISKIMG_SECTOR_SIZE];
-  struct direntv6 *dir = (struct direntv6 *) buf;
+  int indexing = (size / sizeof(struct direntv6)) > DIRECTORY_HASH_MIN_ENTRIES;
+  int recordedAll = 1;  // only a directory recorded in full may be marked complete
+  int found = 0;
   for (int bno=0; bno<numBlocks; bno++) {
     int bytesLeft, numEntriesInBlock, i;
-    bytesLeft = file_getblock(fs, dirinumber, bno, dir);
+    const struct direntv6 *dir;
+    bytesLeft = file_getblockptr(fs, dirinumber, bno, (const void **) &dir);
     if (bytesLeft < 0) {
       fprintf(stderr, "Error reading directory\n");
       return -1;
     }
     numEntriesInBlock = bytesLeft/sizeof(struct direntv6);
     for (i=0; i<numEntriesInBlock ; i++) {
-      if (strcmp(name, dir[i].d_name) == 0) {
+      if (indexing && dentrycache_add(fs->dentries, dirinumber, &dir[i]) < 0) recordedAll = 0;
+      if (!found && strcmp(name, dir[i].d_name) == 0) {
         *dirEnt = dir[i];
-        return 0;
+        found = 1;
+        if (!indexing) {
+          dentrycache_add(fs->dentries, dirinumber, dirEnt);  // failing just means rescanning next time
+          return 0;
+        }
       }
     }
   }
-  return -1;
+  if (indexing && recordedAll) dentrycache_markcomplete(fs->dentries, dirinumber);
+  return found ? 0 : -1;
 }
@@ -1,5 +1,6 @@
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <unistd.h>
 
@@ -14,8 +15,15 @@ int diskimg_getsize(int fd) {
 }
 
 int diskimg_readsector(int fd, int sectorNum,  void *buf) {
-  if (lseek(fd, sectorNum * DISKIMG_SECTOR_SIZE, SEEK_SET) == (off_t) -1) return -1;  
-  return read(fd, buf, DISKIMG_SECTOR_SIZE);
+  return pread(fd, buf, DISKIMG_SECTOR_SIZE, (off_t) sectorNum * DISKIMG_SECTOR_SIZE);
+}
+
+int diskimg_readbytes(int fd, long offset, int len, void *buf) {
+  return pread(fd, buf, len, offset);
+}
+
+void diskimg_prefetch(int fd, long offset, long len) {
+  (void) posix_fadvise(fd, offset, len, POSIX_FADV_WILLNEED);
 }
 
 int diskimg_writesector(int fd, int sectorNum,  void *buf) {
@@ -26,6 +34,17 @@ int diskimg_writesector(int fd, int sectorNum,  void *buf) {
   return write(fd, buf, DISKIMG_SECTOR_SIZE);
 }
 
+const void *diskimg_map(int fd, int *size) {
+  *size = diskimg_getsize(fd);
+  if (*size <= 0) return NULL;
+  void *image = mmap(NULL, *size, PROT_READ, MAP_SHARED, fd, 0);
+  return (image == MAP_FAILED) ? NULL : image;
+}
+
+int diskimg_unmap(const void *image, int size) {
+  return munmap((void *) (uintptr_t) image, size);
+}
+
 int diskimg_close(int fd) {
   return close(fd);
 }
@@ -23,12 +23,38 @@ int diskimg_getsize(int fd);
  */
 int diskimg_readsector(int fd, int sectorNum, void *buf); 
 
+/**
+ * Reads len bytes starting at the specified byte offset into the disk, which
+ * may span many sectors, with a single system call.  Returns the number of
+ * bytes read, or -1 on error.
+ */
+int diskimg_readbytes(int fd, long offset, int len, void *buf);
+
+/**
+ * Advises that len bytes starting at the specified byte offset into the disk
+ * will be read soon, so the kernel can start reading them in the background.
+ */
+void diskimg_prefetch(int fd, long offset, long len);
+
 /**
  * Writes the specified sector from the disk.  Returns the number of bytes
  * written, or -1 on error.
  */
 int diskimg_writesector(int fd, int sectorNum, void *buf); 
 
+/**
+ * Maps the whole disk image into memory, read-only, so that sectors can be
+ * used in place rather than copied out with diskimg_readsector.  Returns a
+ * pointer to the first byte of the image and sets *size to its length in
+ * bytes, or returns NULL on error.
+ */
+const void *diskimg_map(int fd, int *size);
+
+/**
+ * Undoes a previous diskimg_map() call.  Returns 0 on success, or -1 on error.
+ */
+int diskimg_unmap(const void *image, int size);
+
 /**
  * Clean up from a previous diskimg_open() call.  Returns 0 on success, or -1 on
  * error.
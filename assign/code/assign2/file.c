@@ -1,11 +1,18 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #include "file.h"
 #include "inode.h"
 #include "diskimg.h"
 
-int file_getblock(struct unixfilesystem *fs, int inumber, int blockNum, void *buf) {
+/**
+ * Finds the disk sector holding the specified file block.  Returns the sector
+ * number and sets *validBytes to the number of bytes of the block that belong
+ * to the file, or returns -1 on error.
+ */
+static int locateblock(struct unixfilesystem *fs, int inumber, int blockNum, int *validBytes) {
   struct inode in;
   if (inode_iget(fs, inumber, &in) < 0) {
     fprintf(stderr, "Can't read inode %d \n", inumber);
@@ -23,13 +30,90 @@ int file_getblock(struct unixfilesystem *fs, int inumber, int blockNum, void *bu
     fprintf(stderr, "Can't get block num %d for inode %d\n", blockNum, inumber);
     return -1;
   }
-  int bytesRead = diskimg_readsector(fs->dfd, actualBlockNum, buf);
+  readahead_note(fs, inumber, &in, blockNum, 1);
+  *validBytes = (blockNum < maxBlockNum)
+         ? DISKIMG_SECTOR_SIZE
+         : size - maxBlockNum * DISKIMG_SECTOR_SIZE;
+  return actualBlockNum;
+}
+
+int file_getblock(struct unixfilesystem *fs, int inumber, int blockNum, void *buf) {
+  int validBytes;
+  int actualBlockNum = locateblock(fs, inumber, blockNum, &validBytes);
+  if (actualBlockNum < 0) return -1;
+  int bytesRead = unixfilesystem_readsector(fs, actualBlockNum, buf);
   if (bytesRead < 0) {
     fprintf(stderr, "There was a problem reading from the block %d\n", blockNum);
     return -1;
   }
-  int validBytes = (blockNum < maxBlockNum)
-         ? DISKIMG_SECTOR_SIZE
-         : size - maxBlockNum * DISKIMG_SECTOR_SIZE;
   return validBytes;
 }
+
+int file_getblockptr(struct unixfilesystem *fs, int inumber, int blockNum, const void **data) {
+  int validBytes;
+  int actualBlockNum = locateblock(fs, inumber, blockNum, &validBytes);
+  if (actualBlockNum < 0) return -1;
+  *data = unixfilesystem_getsector(fs, actualBlockNum);
+  if (*data == NULL) {
+    fprintf(stderr, "There was a problem reading from the block %d\n", blockNum);
+    return -1;
+  }
+  return validBytes;
+}
+
+/**
+ * Copies len bytes, starting skip bytes into the specified disk block and
+ * carrying on through the blocks after it, into dest.
+ * Returns 0 on success, -1 on error.
+ */
+static int readrun(struct unixfilesystem *fs, int diskBlockNum, int skip, int len, char *dest) {
+  long start = (long) diskBlockNum * DISKIMG_SECTOR_SIZE + skip;
+  if (fs->image != NULL) {
+    if (start + len > fs->imageSize) return -1;
+    memcpy(dest, fs->image + start, len);
+    return 0;
+  }
+  return (diskimg_readbytes(fs->dfd, start, len, dest) == len) ? 0 : -1;
+}
+
+int file_read(struct unixfilesystem *fs, int inumber, int offset, int len, void *buf) {
+  struct inode in;
+  if (inode_iget(fs, inumber, &in) < 0) {
+    fprintf(stderr, "Can't read inode %d \n", inumber);
+    return -1;
+  }
+  int size = inode_getsize(&in);
+  if (offset < 0 || len < 0) return -1;
+  if (offset >= size || len == 0) return 0;
+  if (len > size - offset) len = size - offset;
+
+  int firstBlockNum = offset / DISKIMG_SECTOR_SIZE;
+  int numBlocks = (offset + len - 1) / DISKIMG_SECTOR_SIZE - firstBlockNum + 1;
+  readahead_note(fs, inumber, &in, firstBlockNum, numBlocks);
+  int *diskBlockNums = malloc(numBlocks * sizeof(int));
+  if (diskBlockNums == NULL) return -1;
+  if (inode_indexlookup_range(fs, &in, firstBlockNum, numBlocks, diskBlockNums) < 0) {
+    fprintf(stderr, "Can't get block nums %d-%d for inode %d\n", firstBlockNum, firstBlockNum + numBlocks - 1, inumber);
+    free(diskBlockNums);
+    return -1;
+  }
+
+  for (int i = 0; i < numBlocks; ) {
+    int j = i + 1;
+    while (j < numBlocks && diskBlockNums[j] == diskBlockNums[j-1] + 1) j++;
+    // Blocks i through j-1 sit side by side on the disk, so read them together.
+    int runStart = (firstBlockNum + i) * DISKIMG_SECTOR_SIZE;
+    int runEnd = (firstBlockNum + j) * DISKIMG_SECTOR_SIZE;
+    if (runStart < offset) runStart = offset;
+    if (runEnd > offset + len) runEnd = offset + len;
+    if (readrun(fs, diskBlockNums[i], runStart % DISKIMG_SECTOR_SIZE, runEnd - runStart,
+                (char *) buf + (runStart - offset)) < 0) {
+      fprintf(stderr, "There was a problem reading from the block %d\n", firstBlockNum + i);
+      free(diskBlockNums);
+      return -1;
+    }
+    i = j;
+  }
+  free(diskBlockNums);
+  return len;
+}
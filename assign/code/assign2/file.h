@@ -9,4 +9,21 @@
  */
 int file_getblock(struct unixfilesystem *fs, int inumber, int blockNo, void *buf); 
 
+/**
+ * Like file_getblock, but rather than copying the block into a buffer, points
+ * *data at the filesystem's own copy of it (see unixfilesystem_getsector for
+ * how long that stays valid).
+ * Returns the number of valid bytes in the block, -1 on error.
+ */
+int file_getblockptr(struct unixfilesystem *fs, int inumber, int blockNo, const void **data);
+
+/**
+ * Reads up to len bytes of the specified file, starting at byte offset, into
+ * buf.  The file's block map is resolved once for the whole range, and every
+ * run of physically contiguous blocks is then read from the disk in one go.
+ * Returns the number of bytes read, which is less than len only if the file
+ * ends first, or -1 on error.
+ */
+int file_read(struct unixfilesystem *fs, int inumber, int offset, int len, void *buf);
+
 #endif // _FILE_H_
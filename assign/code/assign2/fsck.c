@@ -0,0 +1,398 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fsck.h"
+#include "inode.h"
+#include "file.h"
+#include "diskimg.h"
+
+#define INODES_PER_BLOCK (DISKIMG_SECTOR_SIZE / sizeof(struct inode))
+#define ADDRS_PER_BLOCK (DISKIMG_SECTOR_SIZE / sizeof(uint16_t))
+#define NUM_SMALL_ADDRS 8
+#define NUM_INDIR_ADDRS 7
+#define NAME_SIZE sizeof(((struct direntv6 *) 0)->d_name)
+#define FREE_LIST_SIZE 100
+
+enum problemkind {
+  BAD_SIZE, BAD_BLOCK, UNREADABLE_BLOCK, BAD_ENTRY_RANGE, BAD_ENTRY_FREE, BAD_ENTRY_NAME, BAD_DOT,
+  LINK_MISMATCH,
+  DUPLICATE_BLOCK, FREE_AND_USED, LEAKED_BLOCK,
+  FREE_TWICE, FREE_OUT_OF_RANGE, BAD_FREE_LIST, UNREADABLE_FREE_LIST
+};
+
+/**
+ * One problem found, about either an inode or (from DUPLICATE_BLOCK on) a
+ * block, which is what where identifies.  value and name are details for
+ * the message.
+ */
+struct problem {
+  int where;
+  int kind;
+  int seq;  // order found, to keep a sort stable
+  int value;
+  int value2;
+  char name[NAME_SIZE + 1];
+};
+
+struct problemlist {
+  struct problem *problems;
+  int num;
+  int max;
+};
+
+/**
+ * State shared by every thread scanning the inode table.
+ */
+struct scan {
+  struct unixfilesystem *fs;
+  int numInodes;
+  int firstDataBlock;
+  int numBlocks;
+  int nextInumber;     // next inode to hand out, bumped atomically
+  uint8_t *owned;      // one bit per block, set once some inode claims it
+  uint8_t *duplicate;  // one bit per block, set once a second claim is made
+  int *refs;           // directory entries naming each inode
+  int *nlinks;         // link count of each inode, or -1 if it isn't allocated
+};
+
+struct worker {
+  struct scan *scan;
+  struct problemlist problems;
+};
+
+static void addproblem(struct problemlist *list, int where, int kind, int value, int value2, const char *name) {
+  if (list->num == list->max) {
+    int max = (list->max == 0) ? 64 : 2 * list->max;
+    struct problem *problems = realloc(list->problems, max * sizeof(struct problem));
+    if (problems == NULL) return;  // the problem goes unreported
+    list->problems = problems;
+    list->max = max;
+  }
+  struct problem *p = &list->problems[list->num];
+  p->where = where;
+  p->kind = kind;
+  p->seq = list->num++;
+  p->value = value;
+  p->value2 = value2;
+  p->name[0] = '\0';
+  if (name != NULL) {
+    strncpy(p->name, name, NAME_SIZE);
+    p->name[NAME_SIZE] = '\0';
+  }
+}
+
+static int testbit(const uint8_t *bits, int n) {
+  return (bits[n / 8] >> (n % 8)) & 1;
+}
+
+/**
+ * Records that the specified inode uses the specified block.  Returns 1 if
+ * the block number is in the data area, and 0 if it's a hole (block 0) or
+ * out of range, in which case there's nothing there to look at.
+ */
+static int claim(struct worker *w, int inumber, int blockNum) {
+  struct scan *scan = w->scan;
+  if (blockNum == 0) return 0;
+  if (blockNum < scan->firstDataBlock || blockNum >= scan->numBlocks) {
+    addproblem(&w->problems, inumber, BAD_BLOCK, blockNum, 0, NULL);
+    return 0;
+  }
+  uint8_t bit = 1 << (blockNum % 8);
+  if (__atomic_fetch_or(&scan->owned[blockNum / 8], bit, __ATOMIC_RELAXED) & bit) {
+    __atomic_fetch_or(&scan->duplicate[blockNum / 8], bit, __ATOMIC_RELAXED);
+  }
+  return 1;
+}
+
+/**
+ * Claims an indirect block and the first count blocks it lists.
+ */
+static void claimindirect(struct worker *w, int inumber, int indirBlockNum, int count) {
+  if (!claim(w, inumber, indirBlockNum)) return;
+  const uint16_t *addrs = unixfilesystem_getsector(w->scan->fs, indirBlockNum);
+  if (addrs == NULL) {
+    addproblem(&w->problems, inumber, UNREADABLE_BLOCK, indirBlockNum, 0, NULL);
+    return;
+  }
+  for (int i = 0; i < count; i++) claim(w, inumber, addrs[i]);
+}
+
+static void claimblocks(struct worker *w, int inumber, struct inode *in) {
+  int size = inode_getsize(in);
+  int numBlocks = (size + DISKIMG_SECTOR_SIZE - 1) / DISKIMG_SECTOR_SIZE;
+  if (!(in->i_mode & ILARG)) {
+    if (numBlocks > NUM_SMALL_ADDRS) {
+      addproblem(&w->problems, inumber, BAD_SIZE, size, 0, NULL);
+      numBlocks = NUM_SMALL_ADDRS;
+    }
+    for (int i = 0; i < numBlocks; i++) claim(w, inumber, in->i_addr[i]);
+    return;
+  }
+
+  int numIndir = (numBlocks + ADDRS_PER_BLOCK - 1) / ADDRS_PER_BLOCK;
+  for (int k = 0; k < numIndir && k < NUM_INDIR_ADDRS; k++) {
+    int remaining = numBlocks - k * ADDRS_PER_BLOCK;
+    claimindirect(w, inumber, in->i_addr[k], remaining < (int) ADDRS_PER_BLOCK ? remaining : (int) ADDRS_PER_BLOCK);
+  }
+  if (numIndir <= NUM_INDIR_ADDRS || !claim(w, inumber, in->i_addr[7])) return;
+
+  // Copy the doubly indirect block, since reading the blocks it lists may
+  // evict it from the sector cache.
+  uint16_t dbl[ADDRS_PER_BLOCK];
+  const uint16_t *addrs = unixfilesystem_getsector(w->scan->fs, in->i_addr[7]);
+  if (addrs == NULL) {
+    addproblem(&w->problems, inumber, UNREADABLE_BLOCK, in->i_addr[7], 0, NULL);
+    return;
+  }
+  memcpy(dbl, addrs, sizeof(dbl));
+  for (int k = NUM_INDIR_ADDRS; k < numIndir && k - NUM_INDIR_ADDRS < (int) ADDRS_PER_BLOCK; k++) {
+    int remaining = numBlocks - k * ADDRS_PER_BLOCK;
+    claimindirect(w, inumber, dbl[k - NUM_INDIR_ADDRS], remaining < (int) ADDRS_PER_BLOCK ? remaining : (int) ADDRS_PER_BLOCK);
+  }
+}
+
+static void checkdirectory(struct worker *w, int inumber, struct inode *in) {
+  struct scan *scan = w->scan;
+  int size = inode_getsize(in);
+  int numBlocks = (size + DISKIMG_SECTOR_SIZE - 1) / DISKIMG_SECTOR_SIZE;
+  // claimblocks has already reported a small file this size as BAD_SIZE;
+  // only its i_addr entries name blocks at all.
+  if (!(in->i_mode & ILARG) && numBlocks > NUM_SMALL_ADDRS) numBlocks = NUM_SMALL_ADDRS;
+  for (int bno = 0; bno < numBlocks; bno++) {
+    // Holes and out-of-range blocks were reported by claimblocks, and
+    // there's nothing there to parse.
+    int blockNum = inode_indexlookup(scan->fs, in, bno);
+    if (blockNum < scan->firstDataBlock || blockNum >= scan->numBlocks) continue;
+    const struct direntv6 *dir;
+    int bytes = file_getblockptr(scan->fs, inumber, bno, (const void **) &dir);
+    if (bytes < 0) {
+      addproblem(&w->problems, inumber, UNREADABLE_BLOCK, blockNum, 0, NULL);
+      return;
+    }
+    // Take a copy, since inode_iget below may evict the block from the cache.
+    struct direntv6 entries[DISKIMG_SECTOR_SIZE / sizeof(struct direntv6)];
+    int numEntries = bytes / sizeof(struct direntv6);
+    memcpy(entries, dir, numEntries * sizeof(struct direntv6));
+    for (int i = 0; i < numEntries; i++) {
+      int target = entries[i].d_inumber;
+      if (target == 0) continue;  // unused slot
+      char name[NAME_SIZE + 1];
+      strncpy(name, entries[i].d_name, NAME_SIZE);
+      name[NAME_SIZE] = '\0';
+
+      struct inode targetInode;
+      if (target >= scan->numInodes) {
+        addproblem(&w->problems, inumber, BAD_ENTRY_RANGE, target, 0, name);
+        continue;
+      }
+      if (inode_iget(scan->fs, target, &targetInode) < 0 || !(targetInode.i_mode & IALLOC)) {
+        addproblem(&w->problems, inumber, BAD_ENTRY_FREE, target, 0, name);
+        continue;
+      }
+      if (name[0] == '\0') addproblem(&w->problems, inumber, BAD_ENTRY_NAME, target, 0, NULL);
+      if (strcmp(name, ".") == 0 && target != inumber) addproblem(&w->problems, inumber, BAD_DOT, target, 0, NULL);
+      __atomic_fetch_add(&scan->refs[target], 1, __ATOMIC_RELAXED);
+    }
+  }
+}
+
+/**
+ * Thread routine for the pass over the inode table.  Workers claim an inode
+ * block's worth of inodes at a time.
+ */
+static void *scaninodes(void *arg) {
+  struct worker *w = arg;
+  struct scan *scan = w->scan;
+  while (1) {
+    int first = __atomic_fetch_add(&scan->nextInumber, INODES_PER_BLOCK, __ATOMIC_RELAXED);
+    if (first >= scan->numInodes) return NULL;
+    int last = (first + (int) INODES_PER_BLOCK < scan->numInodes) ? first + (int) INODES_PER_BLOCK : scan->numInodes;
+    for (int inumber = first; inumber < last; inumber++) {
+      struct inode in;
+      scan->nlinks[inumber] = -1;
+      if (inode_iget(scan->fs, inumber, &in) < 0 || !(in.i_mode & IALLOC)) continue;
+      scan->nlinks[inumber] = in.i_nlink;
+      claimblocks(w, inumber, &in);
+      if ((in.i_mode & IFMT) == IFDIR) checkdirectory(w, inumber, &in);
+    }
+  }
+}
+
+/**
+ * Records that the specified block is on the free list.  Returns 1 if it's in
+ * the data area and wasn't already recorded, and 0 otherwise.
+ */
+static int markfree(struct scan *scan, uint8_t *freeBlocks, struct problemlist *problems, int blockNum) {
+  if (blockNum < scan->firstDataBlock || blockNum >= scan->numBlocks) {
+    addproblem(problems, blockNum, FREE_OUT_OF_RANGE, 0, 0, NULL);
+    return 0;
+  }
+  if (testbit(freeBlocks, blockNum)) {
+    addproblem(problems, blockNum, FREE_TWICE, 0, 0, NULL);
+    return 0;
+  }
+  freeBlocks[blockNum / 8] |= 1 << (blockNum % 8);
+  return 1;
+}
+
+/**
+ * Marks every block on the free list in freeBlocks, following the chain of
+ * free list blocks that starts in the superblock.  As in the v6 allocator,
+ * entries 1 through n-1 of each list are free blocks, and entry 0 is the
+ * next free list block (itself free), or 0 at the end of the chain.
+ */
+static void walkfreelist(struct scan *scan, uint8_t *freeBlocks, struct problemlist *problems, int *numFree) {
+  uint16_t chain[1 + FREE_LIST_SIZE];
+  const uint16_t *list = scan->fs->superblock.s_free;
+  int n = scan->fs->superblock.s_nfree;
+  // Each chain block frees at least one block, so this bounds any cycle.
+  for (int steps = 0; n > 0 && steps < scan->numBlocks; steps++) {
+    if (n > FREE_LIST_SIZE) {
+      addproblem(problems, 0, BAD_FREE_LIST, n, 0, NULL);
+      return;
+    }
+    for (int i = 1; i < n; i++) {
+      if (markfree(scan, freeBlocks, problems, list[i])) (*numFree)++;
+    }
+    if (list[0] == 0) return;  // end of the chain
+    if (!markfree(scan, freeBlocks, problems, list[0])) return;
+    (*numFree)++;
+    const uint16_t *next = unixfilesystem_getsector(scan->fs, list[0]);
+    if (next == NULL) {
+      addproblem(problems, list[0], UNREADABLE_FREE_LIST, 0, 0, NULL);
+      return;
+    }
+    memcpy(chain, next, sizeof(chain));
+    n = chain[0];
+    list = chain + 1;
+  }
+}
+
+static int compareproblems(const void *a, const void *b) {
+  const struct problem *p = a, *q = b;
+  int pblock = p->kind >= DUPLICATE_BLOCK, qblock = q->kind >= DUPLICATE_BLOCK;
+  if (pblock != qblock) return pblock - qblock;
+  if (p->where != q->where) return (p->where < q->where) ? -1 : 1;
+  if ((p->kind == LINK_MISMATCH) != (q->kind == LINK_MISMATCH)) return (p->kind == LINK_MISMATCH) ? 1 : -1;
+  return p->seq - q->seq;
+}
+
+static void printproblem(const struct problem *p, FILE *f) {
+  switch (p->kind) {
+  case BAD_SIZE: fprintf(f, "Inode %d: size %d is too big for a small file\n", p->where, p->value); break;
+  case BAD_BLOCK: fprintf(f, "Inode %d: block number %d is outside the data area\n", p->where, p->value); break;
+  case UNREADABLE_BLOCK: fprintf(f, "Inode %d: can't read block %d\n", p->where, p->value); break;
+  case BAD_ENTRY_RANGE: fprintf(f, "Inode %d: entry \"%s\" names nonexistent inode %d\n", p->where, p->name, p->value); break;
+  case BAD_ENTRY_FREE: fprintf(f, "Inode %d: entry \"%s\" names unallocated inode %d\n", p->where, p->name, p->value); break;
+  case BAD_ENTRY_NAME: fprintf(f, "Inode %d: entry for inode %d has an empty name\n", p->where, p->value); break;
+  case BAD_DOT: fprintf(f, "Inode %d: entry \".\" names inode %d\n", p->where, p->value); break;
+  case LINK_MISMATCH: fprintf(f, "Inode %d: link count %d, directory references %d\n", p->where, p->value, p->value2); break;
+  case DUPLICATE_BLOCK: fprintf(f, "Block %d: claimed more than once\n", p->where); break;
+  case FREE_AND_USED: fprintf(f, "Block %d: both in use and free\n", p->where); break;
+  case LEAKED_BLOCK: fprintf(f, "Block %d: neither in use nor free\n", p->where); break;
+  case FREE_TWICE: fprintf(f, "Block %d: on the free list more than once\n", p->where); break;
+  case FREE_OUT_OF_RANGE: fprintf(f, "Block %d: on the free list but outside the data area\n", p->where); break;
+  case BAD_FREE_LIST: fprintf(f, "Free list: block count %d is more than %d\n", p->value, FREE_LIST_SIZE); break;
+  case UNREADABLE_FREE_LIST: fprintf(f, "Block %d: free list block can't be read\n", p->where); break;
+  }
+}
+
+/**
+ * Runs every pass, once fsck_check has allocated everything needed, and
+ * returns the number of problems found.
+ */
+static int checkall(struct scan *scan, uint8_t *freeBlocks, struct worker *workers, pthread_t *threads,
+                    int numThreads, FILE *f, struct fsckreport *report) {
+  // Pass 1: the inode table, along with indirect blocks and directories.
+  int numStarted = 0;
+  for (int t = 0; t < numThreads; t++) workers[t].scan = scan;
+  if (numThreads > 1) {
+    for (; numStarted < numThreads; numStarted++) {
+      if (pthread_create(&threads[numStarted], NULL, scaninodes, &workers[numStarted]) != 0) break;
+    }
+  }
+  if (numStarted == 0) scaninodes(&workers[0]);
+  for (int t = 0; t < numStarted; t++) pthread_join(threads[t], NULL);
+
+  // Pass 2: the free list.
+  struct fsckreport totals;
+  memset(&totals, 0, sizeof(totals));
+  struct problemlist problems = { NULL, 0, 0 };
+  walkfreelist(scan, freeBlocks, &problems, &totals.numBlocksFree);
+
+  // Everything else, including the link counts pass 1 recorded, is done in memory.
+  for (int b = scan->firstDataBlock; b < scan->numBlocks; b++) {
+    int owned = testbit(scan->owned, b), free = testbit(freeBlocks, b);
+    if (owned) totals.numBlocksInUse++;
+    if (testbit(scan->duplicate, b)) addproblem(&problems, b, DUPLICATE_BLOCK, 0, 0, NULL);
+    if (owned && free) addproblem(&problems, b, FREE_AND_USED, 0, 0, NULL);
+    if (!owned && !free) addproblem(&problems, b, LEAKED_BLOCK, 0, 0, NULL);
+  }
+  for (int inumber = 1; inumber < scan->numInodes; inumber++) {
+    if (scan->nlinks[inumber] < 0) continue;
+    totals.numInodes++;
+    if (scan->nlinks[inumber] != scan->refs[inumber]) {
+      addproblem(&problems, inumber, LINK_MISMATCH, scan->nlinks[inumber], scan->refs[inumber], NULL);
+    }
+  }
+
+  for (int t = 0; t < numThreads; t++) {
+    for (int i = 0; i < workers[t].problems.num; i++) {
+      const struct problem *p = &workers[t].problems.problems[i];
+      addproblem(&problems, p->where, p->kind, p->value, p->value2, p->name);
+    }
+  }
+  qsort(problems.problems, problems.num, sizeof(struct problem), compareproblems);
+  for (int i = 0; i < problems.num; i++) {
+    const struct problem *p = &problems.problems[i];
+    printproblem(p, f);
+    if (p->kind == LINK_MISMATCH) totals.numLinkMismatches++;
+    else if (p->kind == DUPLICATE_BLOCK) totals.numDuplicateBlocks++;
+    else if (p->kind == LEAKED_BLOCK) totals.numLeakedBlocks++;
+    else if (p->kind >= FREE_AND_USED) totals.numFreeListProblems++;
+    else totals.numInodeProblems++;
+  }
+  int numProblems = problems.num;
+  free(problems.problems);
+  fprintf(f, "fsck: %d inodes, %d blocks in use, %d free, %d problems\n",
+          totals.numInodes, totals.numBlocksInUse, totals.numBlocksFree, numProblems);
+  if (report != NULL) *report = totals;
+  return numProblems;
+}
+
+int fsck_check(struct unixfilesystem *fs, int numThreads, FILE *f, struct fsckreport *report) {
+  if (fs->image == NULL || numThreads < 1) numThreads = 1;
+  struct scan scan;
+  scan.fs = fs;
+  scan.numInodes = fs->superblock.s_isize * INODES_PER_BLOCK + 1;  // inumbers start at 1
+  scan.firstDataBlock = INODE_START_SECTOR + fs->superblock.s_isize;
+  scan.numBlocks = fs->superblock.s_fsize;
+  scan.nextInumber = 1;
+  int bitmapSize = scan.numBlocks / 8 + 1;
+  scan.owned = calloc(bitmapSize, 1);
+  scan.duplicate = calloc(bitmapSize, 1);
+  scan.refs = calloc(scan.numInodes, sizeof(int));
+  scan.nlinks = malloc(scan.numInodes * sizeof(int));
+  uint8_t *freeBlocks = calloc(bitmapSize, 1);
+  struct worker *workers = calloc(numThreads, sizeof(struct worker));
+  pthread_t *threads = malloc(numThreads * sizeof(pthread_t));
+
+  int numProblems = -1;
+  if (scan.owned == NULL || scan.duplicate == NULL || scan.refs == NULL || scan.nlinks == NULL || freeBlocks == NULL ||
+      workers == NULL || threads == NULL) {
+    fprintf(stderr, "Out of memory.\n");
+  } else {
+    numProblems = checkall(&scan, freeBlocks, workers, threads, numThreads, f, report);
+  }
+
+  for (int t = 0; workers != NULL && t < numThreads; t++) free(workers[t].problems.problems);
+  free(scan.owned);
+  free(scan.duplicate);
+  free(scan.refs);
+  free(scan.nlinks);
+  free(freeBlocks);
+  free(workers);
+  free(threads);
+  return numProblems;
+}
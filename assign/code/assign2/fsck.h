@@ -0,0 +1,46 @@
+#ifndef _FSCK_H_
+#define _FSCK_H_
+
+#include <stdio.h>
+#include "unixfilesystem.h"
+
+/**
+ * Totals from a consistency check, for callers that want more than the
+ * printed report.
+ */
+struct fsckreport {
+  int numInodes;          // allocated inodes
+  int numBlocksInUse;     // data and indirect blocks claimed by some inode
+  int numBlocksFree;      // blocks on the free list
+  int numInodeProblems;   // bad block numbers, bad directory entries, etc.
+  int numLinkMismatches;  // inodes whose i_nlink disagrees with the directories
+  int numDuplicateBlocks; // blocks claimed more than once
+  int numLeakedBlocks;    // blocks neither in use nor on the free list
+  int numFreeListProblems;// free blocks also in use, listed twice, or out of range
+};
+
+/**
+ * Checks the filesystem for consistency, in the spirit of fsck, and prints a
+ * line to f for every problem found followed by a summary line.  The checks:
+ *
+ *   - every block number an inode uses lies within the data area,
+ *   - no block is claimed by more than one inode (or twice by one inode),
+ *   - every block in the data area is either in use or on the free list, but
+ *     not both,
+ *   - every directory entry names an allocated inode, and "." names the
+ *     directory itself,
+ *   - every allocated inode's link count matches the number of directory
+ *     entries naming it.
+ *
+ * The inode table is split among numThreads threads, which share one block
+ * ownership bitmap; after that one pass over the inodes, the free list is
+ * walked once and the rest is bookkeeping in memory.  Threads can only share
+ * the filesystem once its image is mapped (see unixfilesystem_mapimage), so
+ * an unmapped filesystem is checked on a single thread.
+ *
+ * Returns the total number of problems found, or -1 if the check itself
+ * couldn't be carried out.  If report isn't NULL, it's filled in as well.
+ */
+int fsck_check(struct unixfilesystem *fs, int numThreads, FILE *f, struct fsckreport *report);
+
+#endif // _FSCK_H_
@@ -0,0 +1,326 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <openssl/sha.h>
+
+#include "hashtree.h"
+#include "inode.h"
+#include "diskimg.h"
+
+#define INODES_PER_BLOCK (DISKIMG_SECTOR_SIZE / sizeof(struct inode))
+#define GROUP_SIZE (HASHTREE_GROUP_BLOCKS * DISKIMG_SECTOR_SIZE)
+#define MAGIC "V6HTREE2"
+#define MAGIC_SIZE 8
+
+/**
+ * One leaf that has to be hashed.
+ */
+struct leafwork {
+  struct hashtree *tree;
+  int group;
+};
+
+/**
+ * State shared by every thread hashing leaves.
+ */
+struct hashwork {
+  struct unixfilesystem *fs;
+  struct leafwork *leaves;
+  int numLeaves;
+  int nextLeaf;  // next leaf to hand out, bumped atomically
+  int failed;    // set if any leaf couldn't be read
+};
+
+static int testbit(const uint8_t *bits, int n) {
+  return (bits[n / 8] >> (n % 8)) & 1;
+}
+
+static int groupbytes(const struct hashtree *tree, int group) {
+  int bytes = tree->size - group * GROUP_SIZE;
+  return (bytes < GROUP_SIZE) ? bytes : GROUP_SIZE;
+}
+
+static int groupblocks(const struct hashtree *tree, int group) {
+  int blocks = tree->numBlocks - group * HASHTREE_GROUP_BLOCKS;
+  return (blocks < HASHTREE_GROUP_BLOCKS) ? blocks : HASHTREE_GROUP_BLOCKS;
+}
+
+static int hashleaf(struct unixfilesystem *fs, const struct hashtree *tree, int group, uint8_t *digest) {
+  SHA_CTX shactx;
+  if (!SHA1_Init(&shactx)) return -1;
+  int first = group * HASHTREE_GROUP_BLOCKS;
+  int remaining = groupbytes(tree, group);
+  for (int b = first; remaining > 0; b++) {
+    const void *sector = unixfilesystem_getsector(fs, tree->blockMap[b]);
+    if (sector == NULL) return -1;
+    int bytes = (remaining < DISKIMG_SECTOR_SIZE) ? remaining : DISKIMG_SECTOR_SIZE;
+    if (!SHA1_Update(&shactx, sector, bytes)) return -1;
+    remaining -= bytes;
+  }
+  return SHA1_Final(digest, &shactx) ? 0 : -1;
+}
+
+static void *hashleaves(void *arg) {
+  struct hashwork *work = arg;
+  while (1) {
+    int i = __atomic_fetch_add(&work->nextLeaf, 1, __ATOMIC_RELAXED);
+    if (i >= work->numLeaves) return NULL;
+    struct leafwork *leaf = &work->leaves[i];
+    if (hashleaf(work->fs, leaf->tree, leaf->group, leaf->tree->leaves[leaf->group]) < 0) {
+      __atomic_store_n(&work->failed, 1, __ATOMIC_RELAXED);
+    }
+  }
+}
+
+static const struct hashtree *findtree(const struct hashtreeset *set, int inumber) {
+  int lo = 0, hi = set->numTrees - 1;
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    if (set->trees[mid].inumber == inumber) return &set->trees[mid];
+    if (set->trees[mid].inumber < inumber) lo = mid + 1;
+    else hi = mid - 1;
+  }
+  return NULL;
+}
+
+/**
+ * Returns 1 if the specified leaf of tree can be copied from oldTree rather
+ * than hashed again, and 0 otherwise.  Without a list of changed sectors, a
+ * modified file has to be hashed again in full, since nothing says which of
+ * its blocks were written, and nothing is copied at all unless modification
+ * times are trusted.
+ */
+static int leafunchanged(const struct hashtree *tree, const struct hashtree *oldTree, int group,
+                         const uint8_t *changedSectors, int trustMtime) {
+  if (oldTree == NULL || group >= oldTree->numGroups) return 0;
+  if (changedSectors == NULL && (!trustMtime || tree->mtime != oldTree->mtime)) return 0;
+  if (groupbytes(tree, group) != groupbytes(oldTree, group)) return 0;
+  int first = group * HASHTREE_GROUP_BLOCKS, count = groupblocks(tree, group);
+  if (memcmp(&tree->blockMap[first], &oldTree->blockMap[first], count * sizeof(uint16_t)) != 0) return 0;
+  for (int b = first; changedSectors != NULL && b < first + count; b++) {
+    if (testbit(changedSectors, tree->blockMap[b])) return 0;
+  }
+  return 1;
+}
+
+/**
+ * Fills in everything about the tree but its digests, which is everything
+ * the inode and its indirect blocks say.  Returns 0 on success, 1 if the
+ * inode's blocks can't be resolved (its size doesn't fit its addresses, or an
+ * indirect block or a block number is bad), and -1 on error.
+ */
+static int inittree(struct unixfilesystem *fs, int inumber, struct inode *in, struct hashtree *tree) {
+  tree->inumber = inumber;
+  tree->size = inode_getsize(in);
+  tree->mtime = ((uint32_t) in->i_mtime[0] << 16) | in->i_mtime[1];
+  tree->numBlocks = (tree->size + DISKIMG_SECTOR_SIZE - 1) / DISKIMG_SECTOR_SIZE;
+  tree->numGroups = (tree->numBlocks + HASHTREE_GROUP_BLOCKS - 1) / HASHTREE_GROUP_BLOCKS;
+  tree->blockMap = malloc((tree->numBlocks + 1) * sizeof(uint16_t));
+  tree->leaves = malloc((tree->numGroups + 1) * CHKSUMFILE_SIZE);
+  int *diskBlockNums = malloc((tree->numBlocks + 1) * sizeof(int));
+  int err = 1;
+  if (tree->blockMap == NULL || tree->leaves == NULL || diskBlockNums == NULL) {
+    fprintf(stderr, "Out of memory.\n");
+    err = -1;
+  } else if (inode_indexlookup_range(fs, in, 0, tree->numBlocks, diskBlockNums) == 0) {
+    err = 0;
+    for (int b = 0; b < tree->numBlocks; b++) {
+      if (diskBlockNums[b] < 0 || diskBlockNums[b] >= fs->superblock.s_fsize) err = 1;
+      tree->blockMap[b] = diskBlockNums[b];
+    }
+  }
+  free(diskBlockNums);
+  return err;
+}
+
+static int hashroot(struct hashtree *tree) {
+  SHA_CTX shactx;
+  if (!SHA1_Init(&shactx)) return -1;
+  if (!SHA1_Update(&shactx, tree->leaves, tree->numGroups * CHKSUMFILE_SIZE)) return -1;
+  return SHA1_Final(tree->root, &shactx) ? 0 : -1;
+}
+
+/**
+ * Runs the work list on numThreads threads (or on this one, if threads can't
+ * be started).  Returns 0 if every leaf was hashed, -1 otherwise.
+ */
+static int runwork(struct hashwork *work, int numThreads) {
+  pthread_t *threads = (numThreads > 1) ? malloc(numThreads * sizeof(pthread_t)) : NULL;
+  int numStarted = 0;
+  if (threads != NULL) {
+    for (; numStarted < numThreads; numStarted++) {
+      if (pthread_create(&threads[numStarted], NULL, hashleaves, work) != 0) break;
+    }
+  }
+  if (numStarted == 0) hashleaves(work);
+  for (int t = 0; t < numStarted; t++) pthread_join(threads[t], NULL);
+  free(threads);
+  return work->failed ? -1 : 0;
+}
+
+int hashtree_buildall(struct unixfilesystem *fs, const struct hashtreeset *old, const uint8_t *changedSectors,
+                      int trustMtime, int numThreads, struct hashtreeset *set, int *numHashed) {
+  if (fs->image == NULL || numThreads < 1) numThreads = 1;
+  int numInodes = fs->superblock.s_isize * INODES_PER_BLOCK;
+  set->numTrees = 0;
+  set->trees = calloc(numInodes + 1, sizeof(struct hashtree));
+  if (set->trees == NULL) {
+    fprintf(stderr, "Out of memory.\n");
+    return -1;
+  }
+
+  // Resolve every block map serially: it's cheap next to the hashing, and
+  // the totals it gives size the work list.
+  int numLeaves = 0;
+  for (int inumber = 1; inumber <= numInodes; inumber++) {
+    struct inode in;
+    if (inode_iget(fs, inumber, &in) < 0 || !(in.i_mode & IALLOC)) continue;
+    struct hashtree *tree = &set->trees[set->numTrees++];
+    int err = inittree(fs, inumber, &in, tree);
+    if (err < 0) {
+      hashtree_free(set);
+      return -1;
+    }
+    if (err > 0) {
+      // Like the checksum dumps, report the damaged inode and carry on.
+      fprintf(stderr, "Inode %d can't resolve its blocks, skipping it\n", inumber);
+      free(tree->blockMap);
+      free(tree->leaves);
+      memset(tree, 0, sizeof(*tree));
+      set->numTrees--;
+      continue;
+    }
+    numLeaves += tree->numGroups;
+  }
+
+  struct hashwork work = { fs, malloc((numLeaves + 1) * sizeof(struct leafwork)), 0, 0, 0 };
+  if (work.leaves == NULL) {
+    fprintf(stderr, "Out of memory.\n");
+    hashtree_free(set);
+    return -1;
+  }
+  for (int t = 0; t < set->numTrees; t++) {
+    struct hashtree *tree = &set->trees[t];
+    const struct hashtree *oldTree = (old != NULL) ? findtree(old, tree->inumber) : NULL;
+    for (int g = 0; g < tree->numGroups; g++) {
+      if (leafunchanged(tree, oldTree, g, changedSectors, trustMtime)) {
+        memcpy(tree->leaves[g], oldTree->leaves[g], CHKSUMFILE_SIZE);
+      } else {
+        work.leaves[work.numLeaves].tree = tree;
+        work.leaves[work.numLeaves++].group = g;
+      }
+    }
+  }
+
+  int err = runwork(&work, numThreads);
+  for (int t = 0; err == 0 && t < set->numTrees; t++) err = hashroot(&set->trees[t]);
+  if (numHashed != NULL) *numHashed = work.numLeaves;
+  free(work.leaves);
+  if (err < 0) hashtree_free(set);
+  return err;
+}
+
+uint8_t *hashtree_readsectors(const char *path, int *numChanged) {
+  FILE *f = fopen(path, "r");
+  if (f == NULL) {
+    perror(path);
+    return NULL;
+  }
+
+  // Block numbers are 16 bits wide, so that's all the bitmap has to cover.
+  int numSectors = 65536;
+  uint8_t *changed = calloc(numSectors / 8, 1);
+  int count = 0, ok = changed != NULL, result, s;
+  if (!ok) fprintf(stderr, "Out of memory.\n");
+  while (ok && (result = fscanf(f, "%d", &s)) == 1) {
+    ok = s >= 0 && s < numSectors;
+    if (ok && !testbit(changed, s)) {
+      changed[s / 8] |= 1 << (s % 8);
+      count++;
+    }
+  }
+  if (ok && result != EOF) ok = 0;
+  fclose(f);
+  if (!ok) {
+    if (changed != NULL) fprintf(stderr, "%s isn't a list of sector numbers\n", path);
+    free(changed);
+    return NULL;
+  }
+  if (numChanged != NULL) *numChanged = count;
+  return changed;
+}
+
+int hashtree_save(const struct hashtreeset *set, const char *path) {
+  FILE *f = fopen(path, "wb");
+  if (f == NULL) {
+    perror(path);
+    return -1;
+  }
+  int ok = fwrite(MAGIC, MAGIC_SIZE, 1, f) == 1;
+  int header[2] = { HASHTREE_GROUP_BLOCKS, set->numTrees };
+  ok = ok && fwrite(header, sizeof(header), 1, f) == 1;
+  for (int t = 0; ok && t < set->numTrees; t++) {
+    const struct hashtree *tree = &set->trees[t];
+    int fields[4] = { tree->inumber, tree->size, tree->numBlocks, (int) tree->mtime };
+    ok = fwrite(fields, sizeof(fields), 1, f) == 1 &&
+         fwrite(tree->blockMap, sizeof(uint16_t), tree->numBlocks, f) == (size_t) tree->numBlocks &&
+         fwrite(tree->leaves, CHKSUMFILE_SIZE, tree->numGroups, f) == (size_t) tree->numGroups &&
+         fwrite(tree->root, CHKSUMFILE_SIZE, 1, f) == 1;
+  }
+  if (fclose(f) != 0) ok = 0;
+  if (!ok) fprintf(stderr, "Error writing %s\n", path);
+  return ok ? 0 : -1;
+}
+
+int hashtree_load(struct hashtreeset *set, const char *path) {
+  FILE *f = fopen(path, "rb");
+  if (f == NULL) {
+    perror(path);
+    return -1;
+  }
+  set->numTrees = 0;
+  set->trees = NULL;
+  char magic[MAGIC_SIZE];
+  int header[2];
+  int ok = fread(magic, MAGIC_SIZE, 1, f) == 1 && memcmp(magic, MAGIC, MAGIC_SIZE) == 0 &&
+           fread(header, sizeof(header), 1, f) == 1 && header[0] == HASHTREE_GROUP_BLOCKS &&
+           header[1] >= 0 && header[1] <= 65536;
+  if (ok) ok = (set->trees = calloc(header[1] + 1, sizeof(struct hashtree))) != NULL;
+  for (int t = 0; ok && t < header[1]; t++) {
+    struct hashtree *tree = &set->trees[set->numTrees];
+    int fields[4];
+    ok = fread(fields, sizeof(fields), 1, f) == 1 && fields[2] >= 0 &&
+         fields[2] == (fields[1] + DISKIMG_SECTOR_SIZE - 1) / DISKIMG_SECTOR_SIZE;
+    if (!ok) break;
+    set->numTrees++;
+    tree->inumber = fields[0];
+    tree->size = fields[1];
+    tree->numBlocks = fields[2];
+    tree->mtime = fields[3];
+    tree->numGroups = (tree->numBlocks + HASHTREE_GROUP_BLOCKS - 1) / HASHTREE_GROUP_BLOCKS;
+    tree->blockMap = malloc((tree->numBlocks + 1) * sizeof(uint16_t));
+    tree->leaves = malloc((tree->numGroups + 1) * CHKSUMFILE_SIZE);
+    ok = tree->blockMap != NULL && tree->leaves != NULL &&
+         fread(tree->blockMap, sizeof(uint16_t), tree->numBlocks, f) == (size_t) tree->numBlocks &&
+         fread(tree->leaves, CHKSUMFILE_SIZE, tree->numGroups, f) == (size_t) tree->numGroups &&
+         fread(tree->root, CHKSUMFILE_SIZE, 1, f) == 1;
+  }
+  fclose(f);
+  if (!ok) {
+    fprintf(stderr, "%s isn't a hash tree file\n", path);
+    hashtree_free(set);
+    return -1;
+  }
+  return 0;
+}
+
+void hashtree_free(struct hashtreeset *set) {
+  for (int t = 0; set->trees != NULL && t < set->numTrees; t++) {
+    free(set->trees[t].blockMap);
+    free(set->trees[t].leaves);
+  }
+  free(set->trees);
+  set->trees = NULL;
+  set->numTrees = 0;
+}
@@ -0,0 +1,83 @@
+#ifndef _HASHTREE_H_
+#define _HASHTREE_H_
+
+#include <stdint.h>
+#include "unixfilesystem.h"
+#include "chksumfile.h"
+
+/**
+ * Per-file hash trees.  A file is split into groups of HASHTREE_GROUP_BLOCKS
+ * blocks, each group is hashed on its own (the leaves), and the file's root
+ * digest is the SHA-1 of its leaf digests in order.  Leaves are independent,
+ * so they can be hashed in parallel, and a saved set of trees lets a later
+ * image be verified incrementally: a leaf only has to be hashed again if one
+ * of its sectors is known to have been written, or (when modification times
+ * are trusted) its file was modified, or the file's block map moved it.
+ */
+
+// Blocks per leaf (32 KB worth).
+#define HASHTREE_GROUP_BLOCKS 64
+
+struct hashtree {
+  int inumber;
+  int size;                           // file size in bytes
+  uint32_t mtime;                     // the inode's modification time
+  int numBlocks;
+  uint16_t *blockMap;                 // disk block of each file block
+  int numGroups;
+  uint8_t (*leaves)[CHKSUMFILE_SIZE]; // one digest per group
+  uint8_t root[CHKSUMFILE_SIZE];
+};
+
+/**
+ * The trees of every allocated inode in an image, in inumber order.
+ */
+struct hashtreeset {
+  int numTrees;
+  struct hashtree *trees;
+};
+
+/**
+ * Builds the tree of every allocated inode, hashing leaves on numThreads
+ * threads (threads need a mapped image; see unixfilesystem_mapimage).
+ *
+ * If old isn't NULL, it should hold the trees of an earlier version of the
+ * image.  A leaf whose file, size, and blocks are the same as before is then
+ * copied rather than hashed, provided its data is known not to have changed:
+ * if changedSectors isn't NULL, it's a bitmap of the sectors written since
+ * (see hashtree_readsectors), and none of the leaf's may be among them;
+ * otherwise, if trustMtime is nonzero, the file's modification time must be
+ * unchanged too.  Only the inodes, the indirect blocks, and the leaves
+ * actually hashed are read, so anything that changed a copied leaf without
+ * being listed (or, with trustMtime, without touching the modification time,
+ * like bit rot or a tool that preserves it) goes unnoticed.  With neither,
+ * every leaf is hashed, which is the only way to verify the data itself.  If
+ * numHashed isn't NULL, it's set to the number of leaves hashed.
+ *
+ * Returns 0 on success, -1 on error.  Inodes whose blocks can't be resolved
+ * are reported and left out.
+ */
+int hashtree_buildall(struct unixfilesystem *fs, const struct hashtreeset *old, const uint8_t *changedSectors,
+                      int trustMtime, int numThreads, struct hashtreeset *set, int *numHashed);
+
+/**
+ * Reads a list of sector numbers, separated by whitespace, from the specified
+ * file (typically kept by whatever writes the image), and returns a bitmap (to
+ * be freed by the caller) with a bit set for each, or NULL on error.  If
+ * numChanged isn't NULL, it's set to the number of bits set.
+ */
+uint8_t *hashtree_readsectors(const char *path, int *numChanged);
+
+/**
+ * Writes a set of trees to the specified file, or reads one back.  Both
+ * return 0 on success, -1 on error.
+ */
+int hashtree_save(const struct hashtreeset *set, const char *path);
+int hashtree_load(struct hashtreeset *set, const char *path);
+
+/**
+ * Frees everything a set of trees holds (but not the set itself).
+ */
+void hashtree_free(struct hashtreeset *set);
+
+#endif // _HASHTREE_H_
@@ -13,9 +13,8 @@
 
 int inode_iget(struct unixfilesystem *fs, int inumber, struct inode *inp) {
   int offset = (inumber-1) / INODE_PER_BLOCK;
-  struct inode buf[INODE_PER_BLOCK];
-  int bytesRead = diskimg_readsector(fs->dfd, INODE_START_SECTOR + offset, buf);
-  if (bytesRead != DISKIMG_SECTOR_SIZE) {
+  const struct inode *buf = unixfilesystem_getsector(fs, INODE_START_SECTOR + offset);
+  if (buf == NULL) {
     fprintf(stderr, "Error reading inode %d\n", inumber);
     return -1;
   }
@@ -28,20 +27,55 @@ int inode_indexlookup(struct unixfilesystem *fs, struct inode *inp, int blockNum
     // not a large file
     return inp->i_addr[blockNum];
   }
-  uint16_t buf[BLOCKS_PER_INDIR];
+  // Indirect blocks are shared by hundreds of consecutive file blocks, so
+  // they're nearly always already in memory.
+  const uint16_t *buf;
   if (blockNum < TOTAL_BLOCKS_FROM_INDIR) {
     // singly indirect
     // each block 256 * 2-byte block numbers
     int indirBlockNum = blockNum / BLOCKS_PER_INDIR;
-    diskimg_readsector(fs->dfd, inp->i_addr[indirBlockNum], buf);
-    return buf[blockNum % BLOCKS_PER_INDIR];
+    buf = unixfilesystem_getsector(fs, inp->i_addr[indirBlockNum]);
   } else {
     // doubly indirect
     int indirBlockNum = (blockNum - TOTAL_BLOCKS_FROM_INDIR) / BLOCKS_PER_INDIR;
-    diskimg_readsector(fs->dfd, inp->i_addr[7], buf);
-    diskimg_readsector(fs->dfd, buf[indirBlockNum], buf);
-    return buf[blockNum % BLOCKS_PER_INDIR];
+    buf = unixfilesystem_getsector(fs, inp->i_addr[7]);
+    if (buf == NULL) return -1;
+    buf = unixfilesystem_getsector(fs, buf[indirBlockNum]);
   }
+  if (buf == NULL) return -1;
+  return buf[blockNum % BLOCKS_PER_INDIR];
+}
+
+int inode_indexlookup_range(struct unixfilesystem *fs, struct inode *inp,
+                            int firstBlockNum, int numBlocks, int *diskBlockNums) {
+  if (!(inp->i_mode & ILARG)) {
+    // not a large file
+    if (firstBlockNum < 0 || firstBlockNum + numBlocks > 8) return -1;
+    for (int i = 0; i < numBlocks; i++) diskBlockNums[i] = inp->i_addr[firstBlockNum + i];
+    return 0;
+  }
+  // Walk the indirect blocks in order, fetching each one only once.
+  const uint16_t *buf = NULL;
+  int currentIndir = -1;
+  for (int i = 0; i < numBlocks; i++) {
+    int blockNum = firstBlockNum + i;
+    int indirIndex = blockNum / BLOCKS_PER_INDIR;
+    if (indirIndex != currentIndir) {
+      if (blockNum < TOTAL_BLOCKS_FROM_INDIR) {
+        // singly indirect
+        buf = unixfilesystem_getsector(fs, inp->i_addr[indirIndex]);
+      } else {
+        // doubly indirect
+        const uint16_t *dbl = unixfilesystem_getsector(fs, inp->i_addr[7]);
+        if (dbl == NULL || indirIndex - NUM_INDIR_BLOCKS >= BLOCKS_PER_INDIR) return -1;
+        buf = unixfilesystem_getsector(fs, dbl[indirIndex - NUM_INDIR_BLOCKS]);
+      }
+      if (buf == NULL) return -1;
+      currentIndir = indirIndex;
+    }
+    diskBlockNums[i] = buf[blockNum % BLOCKS_PER_INDIR];
+  }
+  return 0;
 }
 
 int inode_getsize(struct inode *inp) {
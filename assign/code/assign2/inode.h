@@ -17,6 +17,16 @@ int inode_iget(struct unixfilesystem *fs, int inumber, struct inode *inp);
  */
 int inode_indexlookup(struct unixfilesystem *fs, struct inode *inp, int blockNum);
 
+/**
+ * Looks up the disk block numbers of numBlocks consecutive file blocks,
+ * starting with firstBlockNum, and stores them in diskBlockNums.  Each
+ * indirect block involved is read only once.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int inode_indexlookup_range(struct unixfilesystem *fs, struct inode *inp,
+                            int firstBlockNum, int numBlocks, int *diskBlockNums);
+
 int inode_indexlookup_indirect(struct unixfilesystem *fs, struct inode *inp, int blockNum);
 
 /**
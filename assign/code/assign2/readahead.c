@@ -0,0 +1,55 @@
+#include <string.h>
+
+#include "readahead.h"
+#include "unixfilesystem.h"
+#include "inode.h"
+#include "diskimg.h"
+
+// Most blocks prefetched by one call, bounding the block map on the stack.
+#define READAHEAD_MAX_BLOCKS 256
+
+void readahead_init(struct readahead *ra) {
+  memset(ra, 0, sizeof(struct readahead));
+}
+
+void readahead_note(struct unixfilesystem *fs, int inumber, struct inode *inp,
+                    int firstBlockNum, int numBlocks) {
+  if (fs->image != NULL) return;
+  struct readahead *ra = &fs->readahead;
+  int endBlockNum = firstBlockNum + numBlocks;
+  if (inumber != ra->inumber || firstBlockNum != ra->nextBlockNum) {
+    // Not a continuation of the last read, so don't guess yet.
+    ra->inumber = inumber;
+    ra->nextBlockNum = ra->prefetchedTo = endBlockNum;
+    return;
+  }
+
+  ra->nextBlockNum = endBlockNum;
+  if (ra->prefetchedTo < endBlockNum) ra->prefetchedTo = endBlockNum;
+  // Top the window up only once half of it has been consumed, so that each
+  // prefetch request covers a worthwhile stretch of the file.
+  int window = (numBlocks > READAHEAD_BLOCKS) ? numBlocks : READAHEAD_BLOCKS;
+  if (ra->prefetchedTo - endBlockNum >= window / 2) return;
+
+  int numFileBlocks = (inode_getsize(inp) + DISKIMG_SECTOR_SIZE - 1) / DISKIMG_SECTOR_SIZE;
+  int first = ra->prefetchedTo;
+  int count = endBlockNum + window - first;
+  if (count > READAHEAD_MAX_BLOCKS) count = READAHEAD_MAX_BLOCKS;
+  if (count > numFileBlocks - first) count = numFileBlocks - first;
+  if (count <= 0) return;
+
+  // Resolving the block map reads any indirect blocks needed into the sector
+  // cache, where the reads themselves will find them.
+  int diskBlockNums[READAHEAD_MAX_BLOCKS];
+  if (inode_indexlookup_range(fs, inp, first, count, diskBlockNums) < 0) return;
+  for (int i = 0; i < count; ) {
+    int j = i + 1;
+    while (j < count && diskBlockNums[j] == diskBlockNums[j-1] + 1) j++;
+    diskimg_prefetch(fs->dfd, (long) diskBlockNums[i] * DISKIMG_SECTOR_SIZE,
+                     (long) (j - i) * DISKIMG_SECTOR_SIZE);
+    ra->numRequests++;
+    i = j;
+  }
+  ra->numBlocks += count;
+  ra->prefetchedTo = first + count;
+}
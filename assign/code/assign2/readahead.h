@@ -0,0 +1,43 @@
+#ifndef _READAHEAD_H_
+#define _READAHEAD_H_
+
+#include <stdint.h>
+
+/**
+ * Sequential read-ahead for file data.  The filesystem remembers where the
+ * last file read left off, and once a file is being read from front to back
+ * it asks the kernel to start fetching the next READAHEAD_BLOCKS blocks of
+ * it (which may be scattered across the disk) in the background, so that by
+ * the time they're wanted they're already in memory.  Only the sector cache
+ * backend needs this; page faults on a mapped image already trigger the
+ * kernel's own read-ahead.
+ */
+
+// How far ahead of a sequential reader to keep, in blocks (32 KB worth).
+#define READAHEAD_BLOCKS 64
+
+struct unixfilesystem;
+struct inode;
+
+struct readahead {
+  int inumber;          // File being read sequentially, or 0 if none.
+  int nextBlockNum;     // Block a sequential reader would ask for next.
+  int prefetchedTo;     // Blocks before this one have been prefetched.
+  uint64_t numBlocks;   // Blocks prefetched so far.
+  uint64_t numRequests; // Prefetch requests issued to the kernel so far.
+};
+
+/**
+ * Resets the read-ahead state, before any reads.
+ */
+void readahead_init(struct readahead *ra);
+
+/**
+ * Notes that numBlocks blocks of the specified file, starting with
+ * firstBlockNum, are about to be read, and prefetches the blocks after them
+ * if the file is being read sequentially.
+ */
+void readahead_note(struct unixfilesystem *fs, int inumber, struct inode *inp,
+                    int firstBlockNum, int numBlocks);
+
+#endif // _READAHEAD_H_
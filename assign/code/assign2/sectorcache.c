@@ -0,0 +1,160 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "sectorcache.h"
+#include "diskimg.h"
+
+#define NO_SLOT -1
+
+/**
+ * Each cached sector lives in a slot.  Slots are chained two ways: into the
+ * hash bucket for their sector number, and into a single recency list whose
+ * head is the most recently used slot and whose tail is the next to go.
+ */
+struct slot {
+  int sectorNum;   // NO_SLOT if the slot is empty
+  int nextInBucket;
+  int newer;
+  int older;
+};
+
+struct sectorcache {
+  int dfd;
+  int numSlots;
+  int numUsed;
+  int numBuckets;  // a power of two
+  int newest;
+  int oldest;
+  int *buckets;
+  struct slot *slots;
+  uint8_t *data;   // numSlots sectors, one per slot
+  uint64_t hits;
+  uint64_t misses;
+};
+
+static int bucketof(const struct sectorcache *cache, int sectorNum) {
+  return (unsigned int) sectorNum * 2654435761u & (cache->numBuckets - 1);
+}
+
+static void unlink_recency(struct sectorcache *cache, int s) {
+  struct slot *slot = &cache->slots[s];
+  if (slot->newer != NO_SLOT) cache->slots[slot->newer].older = slot->older;
+  else cache->newest = slot->older;
+  if (slot->older != NO_SLOT) cache->slots[slot->older].newer = slot->newer;
+  else cache->oldest = slot->newer;
+}
+
+static void make_newest(struct sectorcache *cache, int s) {
+  struct slot *slot = &cache->slots[s];
+  slot->newer = NO_SLOT;
+  slot->older = cache->newest;
+  if (cache->newest != NO_SLOT) cache->slots[cache->newest].newer = s;
+  cache->newest = s;
+  if (cache->oldest == NO_SLOT) cache->oldest = s;
+}
+
+static void unlink_bucket(struct sectorcache *cache, int s) {
+  int *link = &cache->buckets[bucketof(cache, cache->slots[s].sectorNum)];
+  while (*link != s) link = &cache->slots[*link].nextInBucket;
+  *link = cache->slots[s].nextInBucket;
+}
+
+struct sectorcache *sectorcache_init(int dfd, int numSectors) {
+  if (numSectors < 1) return NULL;
+  struct sectorcache *cache = malloc(sizeof(struct sectorcache));
+  if (cache == NULL) return NULL;
+
+  cache->dfd = dfd;
+  cache->numSlots = numSectors;
+  cache->numUsed = 0;
+  cache->numBuckets = 1;
+  while (cache->numBuckets < 2 * numSectors) cache->numBuckets *= 2;
+  cache->newest = cache->oldest = NO_SLOT;
+  cache->hits = cache->misses = 0;
+  cache->buckets = malloc(cache->numBuckets * sizeof(int));
+  cache->slots = malloc(numSectors * sizeof(struct slot));
+  cache->data = malloc((size_t) numSectors * DISKIMG_SECTOR_SIZE);
+  if (cache->buckets == NULL || cache->slots == NULL || cache->data == NULL) {
+    sectorcache_free(cache);
+    return NULL;
+  }
+
+  for (int b = 0; b < cache->numBuckets; b++) cache->buckets[b] = NO_SLOT;
+  return cache;
+}
+
+/**
+ * Finds the slot holding the specified sector, loading it into a free (or the
+ * least recently used) slot on a miss, and marks it most recently used.
+ * Returns the slot and sets *bytesRead to DISKIMG_SECTOR_SIZE.  If the full
+ * sector couldn't be read, *bytesRead is whatever diskimg_readsector returned
+ * and the slot, which holds any partial sector read, is left empty.
+ */
+static int lookup(struct sectorcache *cache, int sectorNum, int *bytesRead) {
+  int *bucket = &cache->buckets[bucketof(cache, sectorNum)];
+  for (int s = *bucket; s != NO_SLOT; s = cache->slots[s].nextInBucket) {
+    if (cache->slots[s].sectorNum == sectorNum) {
+      cache->hits++;
+      *bytesRead = DISKIMG_SECTOR_SIZE;
+      unlink_recency(cache, s);
+      make_newest(cache, s);
+      return s;
+    }
+  }
+
+  cache->misses++;
+  int s;
+  if (cache->numUsed < cache->numSlots) {
+    s = cache->numUsed++;
+  } else {
+    s = cache->oldest;
+    unlink_recency(cache, s);
+    if (cache->slots[s].sectorNum != NO_SLOT) unlink_bucket(cache, s);
+  }
+
+  uint8_t *sector = cache->data + (size_t) s * DISKIMG_SECTOR_SIZE;
+  *bytesRead = diskimg_readsector(cache->dfd, sectorNum, sector);
+  if (*bytesRead != DISKIMG_SECTOR_SIZE) {
+    // Leave the slot empty, at the old end of the list so it's reused next.
+    cache->slots[s].sectorNum = NO_SLOT;
+    cache->slots[s].newer = NO_SLOT;
+    cache->slots[s].older = cache->oldest;
+    if (cache->oldest != NO_SLOT) cache->slots[cache->oldest].newer = s;
+    cache->oldest = s;
+    if (cache->newest == NO_SLOT) cache->newest = s;
+    return s;
+  }
+
+  cache->slots[s].sectorNum = sectorNum;
+  cache->slots[s].nextInBucket = *bucket;
+  *bucket = s;
+  make_newest(cache, s);
+  return s;
+}
+
+int sectorcache_readsector(struct sectorcache *cache, int sectorNum, void *buf) {
+  int bytesRead;
+  int s = lookup(cache, sectorNum, &bytesRead);
+  // Hand back whatever partial sector there was, as diskimg_readsector would.
+  if (bytesRead > 0) memcpy(buf, cache->data + (size_t) s * DISKIMG_SECTOR_SIZE, bytesRead);
+  return bytesRead;
+}
+
+const void *sectorcache_getsector(struct sectorcache *cache, int sectorNum) {
+  int bytesRead;
+  int s = lookup(cache, sectorNum, &bytesRead);
+  return (bytesRead == DISKIMG_SECTOR_SIZE) ? cache->data + (size_t) s * DISKIMG_SECTOR_SIZE : NULL;
+}
+
+void sectorcache_getstats(const struct sectorcache *cache, uint64_t *hits, uint64_t *misses) {
+  *hits = cache->hits;
+  *misses = cache->misses;
+}
+
+void sectorcache_free(struct sectorcache *cache) {
+  if (cache == NULL) return;
+  free(cache->buckets);
+  free(cache->slots);
+  free(cache->data);
+  free(cache);
+}
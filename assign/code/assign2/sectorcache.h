@@ -0,0 +1,46 @@
+#ifndef _SECTORCACHE_H_
+#define _SECTORCACHE_H_
+
+#include <stdint.h>
+
+/**
+ * A fixed-size cache of disk sectors that sits between the filesystem layers
+ * and diskimg_readsector.  Sectors are evicted least recently used first, and
+ * the cache counts how many requests it could and couldn't satisfy itself.
+ * The contents of the disk image are assumed not to change while the cache is
+ * in use.
+ */
+struct sectorcache;
+
+/**
+ * Allocates a cache holding up to numSectors sectors of the disk image open on
+ * the specified diskimg handle.  Returns NULL on error.
+ */
+struct sectorcache *sectorcache_init(int dfd, int numSectors);
+
+/**
+ * Copies the specified sector into buf, reading it from the disk only if it
+ * isn't already cached.  Returns the number of bytes read, or -1 on error,
+ * just like diskimg_readsector.
+ */
+int sectorcache_readsector(struct sectorcache *cache, int sectorNum, void *buf);
+
+/**
+ * Returns a pointer to the cached copy of the specified sector, reading it
+ * from the disk first if need be, or NULL if the full sector can't be read.
+ * The pointer is only good until the next call on the same cache.
+ */
+const void *sectorcache_getsector(struct sectorcache *cache, int sectorNum);
+
+/**
+ * Reports how many sector requests have been satisfied from the cache (hits)
+ * and how many had to go to the disk (misses).
+ */
+void sectorcache_getstats(const struct sectorcache *cache, uint64_t *hits, uint64_t *misses);
+
+/**
+ * Frees the cache.  The diskimg handle is left open.
+ */
+void sectorcache_free(struct sectorcache *cache);
+
+#endif // _SECTORCACHE_H_
@@ -1,7 +1,10 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "unixfilesystem.h"
 #include "diskimg.h" 
+#include "sectorcache.h"
+#include "dentrycache.h"
 
 /**
  * Allocates and initializes a struct unixfilesystem given a filedescriptor to 
@@ -35,11 +38,55 @@ struct unixfilesystem *unixfilesystem_init(int dfd) {
   }
 
   fs->dfd = dfd;  
+  fs->image = NULL;
+  fs->imageSize = 0;
+  readahead_init(&fs->readahead);
   if (diskimg_readsector(dfd, SUPERBLOCK_SECTOR, &fs->superblock) != DISKIMG_SECTOR_SIZE) {
     fprintf(stderr, "Error reading superblock\n");
     free(fs);
     return NULL;
   }
 
+  fs->cache = sectorcache_init(dfd, UNIXFILESYSTEM_CACHE_SECTORS);
+  fs->dentries = dentrycache_init();
+  if (fs->cache == NULL || fs->dentries == NULL) {
+    fprintf(stderr,"Out of memory.\n");
+    unixfilesystem_free(fs);
+    return NULL;
+  }
+
   return fs;
 }
+
+int unixfilesystem_mapimage(struct unixfilesystem *fs) {
+  if (fs->image != NULL) return 0;
+  int size;
+  const void *image = diskimg_map(fs->dfd, &size);
+  if (image == NULL) return -1;
+  fs->image = image;
+  fs->imageSize = size;
+  return 0;
+}
+
+int unixfilesystem_readsector(struct unixfilesystem *fs, int sectorNum, void *buf) {
+  if (fs->image == NULL) return sectorcache_readsector(fs->cache, sectorNum, buf);
+  if (sectorNum < 0) return -1;
+  long offset = (long) sectorNum * DISKIMG_SECTOR_SIZE;
+  if (offset >= fs->imageSize) return 0;
+  int bytesRead = (fs->imageSize - offset < DISKIMG_SECTOR_SIZE) ? fs->imageSize - offset : DISKIMG_SECTOR_SIZE;
+  memcpy(buf, fs->image + offset, bytesRead);
+  return bytesRead;
+}
+
+const void *unixfilesystem_getsector(struct unixfilesystem *fs, int sectorNum) {
+  if (fs->image == NULL) return sectorcache_getsector(fs->cache, sectorNum);
+  if (sectorNum < 0 || (long) (sectorNum + 1) * DISKIMG_SECTOR_SIZE > fs->imageSize) return NULL;
+  return fs->image + (long) sectorNum * DISKIMG_SECTOR_SIZE;
+}
+
+void unixfilesystem_free(struct unixfilesystem *fs) {
+  if (fs->image != NULL) (void) diskimg_unmap(fs->image, fs->imageSize);
+  sectorcache_free(fs->cache);
+  dentrycache_free(fs->dentries);
+  free(fs);
+}
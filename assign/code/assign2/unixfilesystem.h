@@ -8,6 +8,7 @@
 #include "filsys.h"     // Superblock definition
 #include "ino.h"        // Inode definition
 #include "direntv6.h"   // Directory entry
+#include "readahead.h"
 
 /**
  * The layout of the Unix disk looked as follows:
@@ -25,11 +26,50 @@
 #define ROOT_INUMBER        1
 #define BOOTBLOCK_MAGIC_NUM 0407
 
+// Number of sectors the filesystem keeps cached (256 KB worth).
+#define UNIXFILESYSTEM_CACHE_SECTORS 512
+
+struct sectorcache;
+struct dentrycache;
+
 struct unixfilesystem {
   int dfd; // Handle from the diskimg module to read the diskimg.
   struct filsys superblock;  // The superblock read from the diskimage.
+  struct sectorcache *cache; // Every sector read after the superblock goes through here...
+  const uint8_t *image;      // ...unless the image is mapped, in which case this is non-NULL.
+  int imageSize;             // Size in bytes of the mapped image.
+  struct dentrycache *dentries; // Directory entries already looked up.
+  struct readahead readahead;   // Where sequential file reads are up to.
 };
 
 struct unixfilesystem *unixfilesystem_init(int fd);
 
+/**
+ * Switches the filesystem over to reading the disk image through a read-only
+ * memory mapping of the whole thing, rather than through the sector cache.
+ * Returns 0 on success and -1 if the image can't be mapped, in which case the
+ * sector cache stays in use.
+ */
+int unixfilesystem_mapimage(struct unixfilesystem *fs);
+
+/**
+ * Copies the specified sector into buf.  Returns the number of bytes read, or
+ * -1 on error, just like diskimg_readsector.
+ */
+int unixfilesystem_readsector(struct unixfilesystem *fs, int sectorNum, void *buf);
+
+/**
+ * Returns a pointer to the specified sector without copying it, or NULL if the
+ * full sector can't be read.  If the image is mapped the pointer lasts as long
+ * as the filesystem does; otherwise it points into the sector cache and is only
+ * good until the next sector is read.
+ */
+const void *unixfilesystem_getsector(struct unixfilesystem *fs, int sectorNum);
+
+/**
+ * Frees a struct unixfilesystem returned by unixfilesystem_init, along with its
+ * caches.  The disk image itself is left open.
+ */
+void unixfilesystem_free(struct unixfilesystem *fs);
+
 #endif // _UNIXFILESYSTEM_H_
@@ -11,6 +11,7 @@
 #include <unistd.h>
 #include <sys/wait.h>
 #include <sys/time.h>
+#include <stdlib.h>
 
 static void printArgumentVector(char *argv[]) {
   if (argv == NULL || *argv == NULL) {
@@ -58,8 +59,112 @@ static void sleepTest() {
   printf("Time elapsed: %ld seconds.\n", end.tv_sec - start.tv_sec);
 }
 
+static double secondsSince(const struct timeval *start) {
+  struct timeval end;
+  gettimeofday(&end, NULL);
+  return (end.tv_sec - start->tv_sec) + (end.tv_usec - start->tv_usec) / 1e6;
+}
+
+/**
+ * Reaps every process in pids and returns true if and only if each one
+ * was started and exited with status 0, describing any that didn't.
+ */
+static bool waitForAll(pid_t pids[], const char *names[], size_t n) {
+  bool succeeded = true;
+  for (size_t i = 0; i < n; i++) {
+    int status;
+    if (pids[i] == -1) {
+      printf("FAILED: %s was never started.\n", names[i]);
+      succeeded = false;
+    } else if (waitpid(pids[i], &status, 0) != pids[i]) {
+      printf("FAILED: couldn't wait for %s.\n", names[i]);
+      succeeded = false;
+    } else if (WIFSIGNALED(status)) {
+      printf("FAILED: %s was killed by signal %d.\n", names[i], WTERMSIG(status));
+      succeeded = false;
+    } else if (WEXITSTATUS(status) != 0) {
+      printf("FAILED: %s exited with status %d.\n", names[i], WEXITSTATUS(status));
+      succeeded = false;
+    }
+  }
+  return succeeded;
+}
+
+static void printThroughput(const char *bytes, double seconds) {
+  double gb = strtod(bytes, NULL) / (1 << 30);
+  printf("Time elapsed: %.2f seconds (%.2f GB/s).\n", seconds, seconds > 0 ? gb / seconds : 0.0);
+}
+
+// Prints the number of bytes on stdin, like wc -c, and exits with
+// status 0 only if it's the number passed as the script's $0.
+static char *kCountBytesScript = "count=$(wc -c); echo $count; test $count = $0";
+
+/**
+ * Streams numBytes (a head -c byte count) through a four-stage
+ * pipeline, whose last stage checks that exactly numBytes arrived.
+ * Returns true if and only if every stage succeeded.
+ */
+static bool longPipelineThroughputTest(char *numBytes) {
+  char *argv1[] = {"head", "-c", numBytes, "/dev/zero", NULL};
+  char *argv2[] = {"cat", NULL};
+  char *argv3[] = {"cat", NULL};
+  char *argv4[] = {"sh", "-c", kCountBytesScript, numBytes, NULL};
+  const char *names[] = {"head", "the first cat", "the second cat", "the byte count"};
+  char **argvs[] = {argv1, argv2, argv3, argv4};
+  printf("Pipeline: ");
+  for (size_t i = 0; i < 4; i++) {
+    if (i > 0) printf(" -> ");
+    printArgumentVector(argvs[i]);
+  }
+  printf("\n");
+  fflush(stdout);
+
+  pid_t pids[4];
+  struct timeval start;
+  gettimeofday(&start, NULL);
+  pipeline_n(argvs, 4, pids);
+  if (!waitForAll(pids, names, 4)) return false;
+  printThroughput(numBytes, secondsSince(&start));
+  return true;
+}
+
+/**
+ * Fans numBytes out to three consumers through a relay; each
+ * consumer checks that exactly numBytes arrived.  Returns true
+ * if and only if the producer, the relay, and every consumer
+ * succeeded.
+ */
+static bool fanoutThroughputTest(char *numBytes) {
+  char *producer[] = {"head", "-c", numBytes, "/dev/zero", NULL};
+  char *consumer[] = {"sh", "-c", kCountBytesScript, numBytes, NULL};
+  const char *names[] = {"head", "the relay", "the first byte count", "the second byte count", "the third byte count"};
+  char **consumers[] = {consumer, consumer, consumer};
+  printf("Fanout: ");
+  printArgumentVector(producer);
+  printf(" -> relay -> 3 x ");
+  printArgumentVector(consumer);
+  printf("\n");
+  fflush(stdout);
+
+  pid_t pids[5];
+  struct timeval start;
+  gettimeofday(&start, NULL);
+  pipeline_fanout(producer, consumers, 3, pids);
+  if (!waitForAll(pids, names, 5)) return false;
+  printThroughput(numBytes, secondsSince(&start));
+  return true;
+}
+
+/**
+ * Takes an optional byte count for the throughput tests,
+ * which stream 4 GB by default, and exits with status 1
+ * if either of them fails.
+ */
 int main(int argc, char *argv[]) {
+  char *numBytes = (argc > 1) ? argv[1] : "4294967296";
   simpleTest();
   sleepTest();
-  return 0;
+  bool succeeded = longPipelineThroughputTest(numBytes);
+  succeeded = fanoutThroughputTest(numBytes) && succeeded;
+  return succeeded ? 0 : 1;
 }
@@ -1,62 +1,212 @@
 /**
  * File: pipeline.c
  * ----------------
- * Presents the implementation of the pipeline routine.
+ * Presents the implementation of the pipeline routine,
+ * along with pipeline_n, relay, and pipeline_fanout.
  */
 
+#define _GNU_SOURCE  // for pipe2, splice, tee, and F_SETPIPE_SZ
 #include "pipeline.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+// Capacity the relay asks for its own pipes, which bounds how
+// much it moves per splice (1 MB is the most an unprivileged
+// process may ask for by default).
+#define RELAY_PIPE_SIZE (1 << 20)
+
+/**
+ * Function: spawn
+ * ---------------
+ * Forks off a process that runs argv with infd as its stdin and
+ * outfd as its stdout, and returns its pid, or -1 if the fork fails.
+ * Every pipe end pipeline_n and pipeline_fanout create is close-on-exec,
+ * so each child is left holding only the two descriptors it's handed
+ * (dup2 clears close-on-exec on the copies), and readers see end of
+ * file as soon as their writer exits.
+ */
+static pid_t spawn(char *argv[], int infd, int outfd) {
+  pid_t pid = fork();
+  if (pid == -1) {
+    fprintf(stderr, "Failed to create process for %s.\n", argv[0]);
+    return -1;
+  }
+
+  if (!pid) {
+    // In child process
+    if (infd != STDIN_FILENO) dup2(infd, STDIN_FILENO);
+    if (outfd != STDOUT_FILENO) dup2(outfd, STDOUT_FILENO);
+    execvp(argv[0], argv);
+    fprintf(stderr, "Failed to execute %s.\n", argv[0]);
+    _exit(127);
+  }
+  return pid;
+}
 
 void pipeline(char *argv1[], char *argv2[], pid_t pids[]) {
-  // fds[0] - read, fds[1] - write
-  int fds[2];
-  pipe(fds);
+  char **argvs[] = {argv1, argv2};
+  pipeline_n(argvs, 2, pids);
+}
 
-  pid_t reader = fork();
-  if (reader == -1) {
-    fprintf(stderr, "Failed to create reader process.\n");
-    return;
+void pipeline_n(char **argvs[], size_t n, pid_t pids[]) {
+  int infd = STDIN_FILENO;
+  size_t i = 0;
+  for (; i < n; i++) {
+    // fds[0] - read, fds[1] - write; the last stage writes to our stdout
+    int fds[2] = {STDIN_FILENO, STDOUT_FILENO};
+    if (i + 1 < n && pipe2(fds, O_CLOEXEC) == -1) {
+      fprintf(stderr, "Failed to create pipe.\n");
+      break;
+    }
+
+    pids[i] = spawn(argvs[i], infd, fds[1]);
+
+    // close the ends the child now has
+    if (infd != STDIN_FILENO) close(infd);
+    if (fds[1] != STDOUT_FILENO) close(fds[1]);
+    infd = fds[0];
+    if (pids[i] == -1) {
+      i++;
+      break;
+    }
   }
 
-  if (!reader) {
-    // In child reader process
-    // close write end of pipe
-    close(fds[1]);
+  if (infd != STDIN_FILENO) close(infd);
+  for (; i < n; i++) pids[i] = -1;
+}
+
+static bool isPipe(int fd) {
+  struct stat st;
+  return fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+}
 
-    // exec argv2 using fds[0] as stdin
-    dup2(fds[0], STDIN_FILENO);
-    close(fds[0]);
-    execvp(argv2[0], argv2);
+/**
+ * Function: spliceFully
+ * ---------------------
+ * Moves exactly len bytes out of the pipe from and into to.
+ */
+static bool spliceFully(int from, int to, size_t len) {
+  while (len > 0) {
+    ssize_t moved = splice(from, NULL, to, NULL, len, SPLICE_F_MOVE);
+    if (moved == -1 && errno == EINTR) continue;
+    if (moved <= 0) return false;
+    len -= moved;
   }
+  return true;
+}
 
-  // In parent pipeline process
-  pids[1] = reader;
+/**
+ * Function: teeFully
+ * ------------------
+ * Copies the len bytes held in the pipe chunk into to, leaving them
+ * in chunk.  A single tee usually does it, but tee only writes to
+ * pipes, and stops short when to fills up; since a second tee would
+ * start over from the front of chunk, the fallback is to tee all of
+ * chunk into the empty pipe scratch, drop what to already has, and
+ * splice over the rest.
+ */
+static bool teeFully(int chunk, int to, bool toIsPipe, const int scratch[2], int devnull, size_t len) {
+  ssize_t teed = 0;
+  if (toIsPipe) {
+    do {
+      teed = tee(chunk, to, len, 0);
+    } while (teed == -1 && errno == EINTR);
+    if (teed == -1) return false;
+    if ((size_t) teed == len) return true;
+  }
 
-  // close fds[0] since child reader already has it
-  close(fds[0]);
+  ssize_t copied;
+  do {
+    copied = tee(chunk, scratch[1], len, 0);
+  } while (copied == -1 && errno == EINTR);
+  if (copied == -1 || (size_t) copied != len) return false;
+  return spliceFully(scratch[0], devnull, teed) && spliceFully(scratch[0], to, len - teed);
+}
 
-  pid_t writer = fork();
-  if (writer == -1) {
-    fprintf(stderr, "Failed to create writer process.\n");
-    return;
+/**
+ * Function: relayAll
+ * ------------------
+ * The body of the relay process.  Each round splices as much of infd as
+ * fits into a private pipe, tees it to every output but the last, and
+ * splices it to the last, which empties the pipe for the next round.
+ */
+static bool relayAll(int infd, const int outfds[], size_t numOutfds) {
+  // chunk[0], scratch[0] - read, chunk[1], scratch[1] - write
+  int chunk[2], scratch[2];
+  int devnull = open("/dev/null", O_WRONLY);
+  if (pipe(chunk) == -1 || pipe(scratch) == -1 || devnull == -1) return false;
+
+  // scratch must hold whatever chunk does, so size chunk to match it.
+  fcntl(scratch[1], F_SETPIPE_SZ, RELAY_PIPE_SIZE);
+  int size = fcntl(scratch[1], F_GETPIPE_SZ);
+  fcntl(chunk[1], F_SETPIPE_SZ, size);
+  if (size <= 0 || fcntl(chunk[1], F_GETPIPE_SZ) != size) return false;
+
+  bool toIsPipe[numOutfds + 1];
+  for (size_t i = 0; i < numOutfds; i++) toIsPipe[i] = isPipe(outfds[i]);
+  int last = (numOutfds > 0) ? outfds[numOutfds - 1] : devnull;
+
+  while (true) {
+    ssize_t len = splice(infd, NULL, chunk[1], NULL, size, SPLICE_F_MOVE);
+    if (len == -1 && errno == EINTR) continue;
+    if (len == -1) return false;
+    if (len == 0) return true;
+
+    for (size_t i = 0; i + 1 < numOutfds; i++) {
+      if (!teeFully(chunk[0], outfds[i], toIsPipe[i], scratch, devnull, len)) return false;
+    }
+    if (!spliceFully(chunk[0], last, len)) return false;
   }
+}
 
-  if (!writer) {
-    // In child writer process
-    // close read end of pipe
-    close(fds[0]);
+pid_t relay(int infd, const int outfds[], size_t numOutfds) {
+  pid_t pid = fork();
+  if (pid == -1) {
+    fprintf(stderr, "Failed to create relay process.\n");
+    return -1;
+  }
 
-    // exec argv1 using fds[1] as stdout
-    dup2(fds[1], STDOUT_FILENO);
-    close(fds[1]);
-    execvp(argv1[0], argv1);
+  if (!pid) {
+    // In child relay process
+    if (relayAll(infd, outfds, numOutfds)) _exit(0);
+    perror("relay");
+    _exit(1);
   }
+  return pid;
+}
+
+void pipeline_fanout(char *producer[], char **consumers[], size_t numConsumers, pid_t pids[]) {
+  for (size_t i = 0; i < numConsumers + 2; i++) pids[i] = -1;
 
-  // close fds[1] since child writer already has it
+  // fds[0] - read, fds[1] - write
+  int fds[2];
+  if (pipe2(fds, O_CLOEXEC) == -1) {
+    fprintf(stderr, "Failed to create pipe.\n");
+    return;
+  }
+  pids[0] = spawn(producer, STDIN_FILENO, fds[1]);
   close(fds[1]);
 
-  // In parent pipeline process again
-  pids[0] = writer;
+  int outfds[numConsumers + 1];
+  size_t numStarted = 0;
+  for (; numStarted < numConsumers; numStarted++) {
+    int cfds[2];
+    if (pipe2(cfds, O_CLOEXEC) == -1) {
+      fprintf(stderr, "Failed to create pipe.\n");
+      break;
+    }
+    pids[numStarted + 2] = spawn(consumers[numStarted], cfds[0], STDOUT_FILENO);
+    close(cfds[0]);
+    outfds[numStarted] = cfds[1];
+  }
+
+  // The relay inherits exactly the ends it needs from us, since
+  // we've closed the others; after the fork, only it has them.
+  pids[1] = relay(fds[0], outfds, numStarted);
+  close(fds[0]);
+  for (size_t i = 0; i < numStarted; i++) close(outfds[i]);
 }
@@ -38,4 +38,47 @@
 
 void pipeline(char *argv1[], char *argv2[], pid_t pids[]);
 
+/**
+ * Function: pipeline_n
+ * --------------------
+ * Generalizes pipeline to a chain of n sister processes, the ith
+ * around the argument vector supplied via argvs[i], and places the
+ * process id of the ith in pids[i].  The standard output of each
+ * process is piped to the standard input of the next one, so
+ * pipeline_n(argvs, 2, pids) is the same as
+ * pipeline(argvs[0], argvs[1], pids).
+ */
+
+void pipeline_n(char **argvs[], size_t n, pid_t pids[]);
+
+/**
+ * Function: relay
+ * ---------------
+ * Forks off a process that copies everything it reads from infd
+ * to each of the numOutfds descriptors in outfds, until infd
+ * reaches end of file, and returns its process id (or -1 if it
+ * couldn't be forked).  The data is moved with splice and tee, so
+ * it's never copied into user space; infd and every outfd need to
+ * be pipes, regular files, or anything else splice supports.
+ *
+ * The caller keeps its own copies of the descriptors, and should
+ * normally close them once relay returns, so that readers of the
+ * outfds see end of file when the relay finishes.
+ */
+
+pid_t relay(int infd, const int outfds[], size_t numOutfds);
+
+/**
+ * Function: pipeline_fanout
+ * -------------------------
+ * Spawns a process around the argument vector supplied via producer,
+ * and numConsumers processes around the argument vectors supplied via
+ * consumers, and relays the standard output of the producer to the
+ * standard input of every consumer.  The producer's process id is
+ * placed in pids[0], the relay's in pids[1], and the consumers' in
+ * pids[2] through pids[numConsumers + 1].
+ */
+
+void pipeline_fanout(char *producer[], char **consumers[], size_t numConsumers, pid_t pids[]);
+
 #endif
@@ -120,6 +120,18 @@ static void supplyFdCloseTest() {
   waitForChildProcess(child.pid);
 }
 
+static void missingExecutableTest() {
+  // subprocess spawns rather than forks, so a failed exec is reported in the parent.
+  char *argv[] = {const_cast<char *>("./no-such-executable"), NULL};
+  bool thrown = false;
+  try {
+    subprocess(argv, true, true);
+  } catch (const SubprocessException& se) {
+    thrown = true;
+  }
+  assert(thrown);
+}
+
 int main(int argc, char *argv[]) {
   try {
     supplyAndIngestTest();
@@ -127,6 +139,7 @@ int main(int argc, char *argv[]) {
     noSupplyAndIngestTest();
     noSupplyAndNoIngestTest();
     supplyFdCloseTest();
+    missingExecutableTest();
     return 0;
   } catch (const SubprocessException& se) {
     cerr << "Problem encountered while spawning second process to run \"" << kSortExecutable << "\"." << endl;
@@ -5,9 +5,15 @@
  */
 
 #include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <string.h>
+#include <string>
 #include "subprocess.h"
 using namespace std;
 
+extern char **environ;
+
 void sp_pipe(int fds[2]) throw (SubprocessException) {
   if (pipe(fds) == 0) return;
   switch errno {
@@ -56,9 +62,12 @@ void sp_dup2(int fd, int fd2) {
   }
 }
 
-void sp_execvp(const char *file, char *const argv[]) {
-  execvp(file, argv);
-  switch errno {
+/**
+ * Throws the exception describing why the executable couldn't be run, given
+ * the errno value execvp or posix_spawnp reported.
+ */
+static void sp_throwexecerror(int err) throw (SubprocessException) {
+  switch (err) {
     case E2BIG:
       throw SubprocessException("The number of bytes in the new process's argument list is larger than the system-imposed limit.\n");
     case EACCES:
@@ -91,11 +100,17 @@ void sp_execvp(const char *file, char *const argv[]) {
     case ETXTBSY:
       throw SubprocessException("The new process file is a pure procedure (shared text) file "
                                     "that is currently open for writing or reading by some process.\n");
-
+    default:
+      throw SubprocessException(string("The new process couldn't be started: ") + strerror(err) + "\n");
   }
 }
 
-subprocess_t subprocess(char *argv[], bool supplyChildInput, bool ingestChildOutput) throw (SubprocessException) {
+void sp_execvp(const char *file, char *const argv[]) {
+  execvp(file, argv);
+  sp_throwexecerror(errno);
+}
+
+subprocess_t subprocess_fork(char *argv[], bool supplyChildInput, bool ingestChildOutput) throw (SubprocessException) {
   int supplyFd[2], ingestFd[2];
   sp_pipe(supplyFd);
   sp_pipe(ingestFd);
@@ -107,9 +122,11 @@ subprocess_t subprocess(char *argv[], bool supplyChildInput, bool ingestChildOut
   };
 
   if (sp.pid > 0) {
-    // in parent
+    // in parent, which keeps only the ends that were asked for
     sp_close(supplyFd[0]);
     sp_close(ingestFd[1]);
+    if (!supplyChildInput) sp_close(supplyFd[1]);
+    if (!ingestChildOutput) sp_close(ingestFd[0]);
     return sp;
   }
 
@@ -123,3 +140,71 @@ subprocess_t subprocess(char *argv[], bool supplyChildInput, bool ingestChildOut
   sp_close(ingestFd[1]);
   sp_execvp(argv[0], argv);
 }
+
+/**
+ * Function: sp_pipe_cloexec
+ * -------------------------
+ * Like sp_pipe, except both ends are closed on exec, so that a spawned child
+ * only keeps the ends it's explicitly handed, and a child spawned later (by
+ * this or any other thread) never inherits them at all.
+ */
+static void sp_pipe_cloexec(int fds[2]) throw (SubprocessException) {
+  if (pipe2(fds, O_CLOEXEC) == 0) return;
+  switch (errno) {
+    case EFAULT:
+      throw SubprocessException("The fds buffer is in an invalid area of the process's address space.\n");
+    case EMFILE:
+      throw SubprocessException("Too many descriptors are active.\n");
+    case ENFILE:
+      throw SubprocessException("The system file table is full.\n");
+  }
+  throw SubprocessException("Couldn't create a pipe.\n");
+}
+
+/**
+ * Function: subprocess
+ * --------------------
+ * Launches the child with posix_spawnp, which never copies the parent's page
+ * tables: glibc starts the child with clone(CLONE_VM | CLONE_VFORK), so it
+ * borrows the parent's address space just long enough to rewire its
+ * descriptors and exec.  Only the pipes actually asked for are created, and
+ * any failure to exec is reported back here and thrown in the parent, with
+ * the same messages sp_execvp would have used.
+ */
+subprocess_t subprocess(char *argv[], bool supplyChildInput, bool ingestChildOutput) throw (SubprocessException) {
+  int supplyFd[2] = {kNotInUse, kNotInUse}, ingestFd[2] = {kNotInUse, kNotInUse};
+  if (supplyChildInput) sp_pipe_cloexec(supplyFd);
+  if (ingestChildOutput) {
+    try {
+      sp_pipe_cloexec(ingestFd);
+    } catch (...) {
+      if (supplyChildInput) { close(supplyFd[0]); close(supplyFd[1]); }
+      throw;
+    }
+  }
+
+  // dup2 clears close-on-exec on the new descriptor, so the child keeps
+  // exactly its rewired stdin and stdout.
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  if (supplyChildInput) posix_spawn_file_actions_adddup2(&actions, supplyFd[0], STDIN_FILENO);
+  if (ingestChildOutput) posix_spawn_file_actions_adddup2(&actions, ingestFd[1], STDOUT_FILENO);
+
+  pid_t pid;
+  int err = posix_spawnp(&pid, argv[0], &actions, NULL, argv, environ);
+  posix_spawn_file_actions_destroy(&actions);
+
+  if (supplyChildInput) close(supplyFd[0]);
+  if (ingestChildOutput) close(ingestFd[1]);
+  if (err != 0) {
+    if (supplyChildInput) close(supplyFd[1]);
+    if (ingestChildOutput) close(ingestFd[0]);
+    if (err == EAGAIN) {
+      throw SubprocessException("The system-imposed limit on the total number of processes under execution would be exceeded.\n");
+    }
+    sp_throwexecerror(err);
+  }
+
+  subprocess_t sp = {pid, supplyFd[1], ingestFd[0]};
+  return sp;
+}
@@ -88,5 +88,18 @@ struct subprocess_t {
  *   argv: the NULL-terminated argument vector that should be passed to the new process's main function
  *   supplyChildInput: true if the parent process would like to pipe content to the new process's stdin, false otherwise
  *   ingestChildOutput: true if the parent would like the child's stdout to be pushed to the parent, false otheriwse
+ *
+ * The child is started with posix_spawnp rather than fork, so launching it costs the
+ * same however large the parent's address space is.  If the executable can't be run,
+ * the SubprocessException is thrown here, in the parent.
  */
 subprocess_t subprocess(char *argv[], bool supplyChildInput, bool ingestChildOutput) throw (SubprocessException);
+
+/**
+ * Function: subprocess_fork
+ * -------------------------
+ * The original fork/dup2/execvp implementation of subprocess, with the same arguments
+ * and return value, kept for comparison (see subprocess-bench).  Note that fork copies
+ * the parent's page tables, and that an executable that can't be run throws in the child.
+ */
+subprocess_t subprocess_fork(char *argv[], bool supplyChildInput, bool ingestChildOutput) throw (SubprocessException);
@@ -0,0 +1,89 @@
+/**
+ * File: trace-memory.cc
+ * ---------------------
+ * Presents the implementation of the routines that read tracee memory.
+ */
+
+#include "trace-memory.h"
+#include <errno.h>
+#include <string.h> // for memchr, memcpy
+#include <sys/ptrace.h>
+#include <sys/uio.h> // for process_vm_readv
+#include <vector>
+using namespace std;
+
+static const size_t kPageSize = sysconf(_SC_PAGESIZE);
+
+// Cleared the first time process_vm_readv fails in a way that means it never
+// will work (no kernel support, or not permitted), so every later read goes
+// straight to PTRACE_PEEKDATA instead of paying for a failing call first.
+static bool processVMReadvWorks = true;
+
+/**
+ * Function: peekTraceeMemory
+ * --------------------------
+ * The fallback: copies up to len bytes with PTRACE_PEEKDATA, one word at a time,
+ * and returns the number of bytes copied.  If stopAtNull is true, it stops after
+ * the first word holding a '\0', since a string reader has no use for the rest.
+ */
+static size_t peekTraceeMemory(pid_t pid, unsigned long addr, char *buf, size_t len, bool stopAtNull) {
+  size_t copied = 0;
+  while (copied < len) {
+    // Peek the aligned word holding addr + copied, so a word never straddles a page.
+    unsigned long wordAddr = (addr + copied) & ~(sizeof(long) - 1);
+    size_t offset = addr + copied - wordAddr;
+    errno = 0;
+    long word = ptrace(PTRACE_PEEKDATA, pid, wordAddr, 0);
+    if (word == -1 && errno != 0) break;
+    size_t count = min(sizeof(long) - offset, len - copied);
+    memcpy(buf + copied, (char *) &word + offset, count);
+    copied += count;
+    if (stopAtNull && memchr(buf + copied - count, '\0', count) != NULL) break;
+  }
+  return copied;
+}
+
+/**
+ * Function: readTraceeChunk
+ * -------------------------
+ * Copies up to len bytes, none of them past the end of the page holding addr,
+ * and returns the number of bytes copied.  stopAtNull is passed along to
+ * peekTraceeMemory, so the copy may stop short just past a '\0'.
+ */
+static size_t readTraceeChunk(pid_t pid, unsigned long addr, char *buf, size_t len, bool stopAtNull) {
+  if (processVMReadvWorks) {
+    struct iovec local = {buf, len};
+    struct iovec remote = {(void *) addr, len};
+    ssize_t copied = process_vm_readv(pid, &local, 1, &remote, 1, 0);
+    if (copied > 0) return copied;
+    if (copied == -1 && (errno == EPERM || errno == ENOSYS)) processVMReadvWorks = false;
+  }
+  return peekTraceeMemory(pid, addr, buf, len, stopAtNull);
+}
+
+size_t readTraceeMemory(pid_t pid, unsigned long addr, void *buf, size_t len) {
+  char *dest = static_cast<char *>(buf);
+  size_t copied = 0;
+  while (copied < len) {
+    unsigned long chunkAddr = addr + copied;
+    size_t chunkLen = min(kPageSize - chunkAddr % kPageSize, len - copied);
+    size_t count = readTraceeChunk(pid, chunkAddr, dest + copied, chunkLen, false);
+    copied += count;
+    if (count < chunkLen) break;
+  }
+  return copied;
+}
+
+string readTraceeString(pid_t pid, unsigned long addr) {
+  string str;
+  vector<char> page(kPageSize);  // kPageSize isn't known until run time
+  while (true) {
+    size_t chunkLen = kPageSize - addr % kPageSize;
+    size_t count = readTraceeChunk(pid, addr, page.data(), chunkLen, true);
+    const char *end = static_cast<const char *>(memchr(page.data(), '\0', count));
+    if (end != NULL) return str.append(page.data(), end - page.data());
+    str.append(page.data(), count);
+    if (count < chunkLen) return str;
+    addr += count;
+  }
+}
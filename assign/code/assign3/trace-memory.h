@@ -0,0 +1,30 @@
+/**
+ * File: trace-memory.h
+ * --------------------
+ * Exports routines that read memory out of a process being traced.  Memory is
+ * pulled over with process_vm_readv a page at a time, so reading a string costs
+ * a system call per page rather than per eight bytes; if process_vm_readv isn't
+ * allowed or fails, the routines fall back on PTRACE_PEEKDATA.
+ */
+
+#pragma once
+#include <string>
+#include <unistd.h> // for pid_t
+
+/**
+ * Function: readTraceeMemory
+ * --------------------------
+ * Copies up to len bytes starting at addr in the address space of the stopped
+ * tracee pid into buf, and returns the number of bytes copied, which is less than
+ * len only if the tracee's memory past that point can't be read.
+ */
+size_t readTraceeMemory(pid_t pid, unsigned long addr, void *buf, size_t len);
+
+/**
+ * Function: readTraceeString
+ * --------------------------
+ * Returns the null-terminated string that starts at addr in the address space of
+ * the stopped tracee pid, without the terminator.  If the tracee's memory can't be
+ * read all the way to a terminator, whatever could be read is returned.
+ */
+std::string readTraceeString(pid_t pid, unsigned long addr);
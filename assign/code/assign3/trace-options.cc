@@ -11,11 +11,20 @@ using namespace std;
 
 static const string kSimpleFlag = "--simple";
 static const string kRebuildFlag = "--rebuild";
-size_t processCommandLineFlags(bool& simple, bool& rebuild, char *argv[]) throw (TraceException) {  
+static const string kOnlyFlagPrefix = "--only=";
+size_t processCommandLineFlags(bool& simple, bool& rebuild, vector<string>& onlySystemCalls,
+                               char *argv[]) throw (TraceException) {  
   size_t numFlags = 0;
   for (int i = 1; argv[i] != NULL && startsWith(argv[i], "--"); i++) {
     if (argv[i] == kSimpleFlag) simple = true;
     else if (argv[i] == kRebuildFlag) rebuild = true;
+    else if (startsWith(argv[i], kOnlyFlagPrefix)) {
+      string names = string(argv[i]).substr(kOnlyFlagPrefix.size()) + ",";
+      for (size_t start = 0, end; (end = names.find(',', start)) != string::npos; start = end + 1) {
+        if (end > start) onlySystemCalls.push_back(names.substr(start, end - start));
+      }
+      if (onlySystemCalls.empty()) throw TraceException(string(argv[0]) + ": No system calls listed (" + argv[i] + " )");
+    }
     else throw TraceException(string(argv[0]) + ": Unrecognized flag (" + argv[i] + " )");
     numFlags++;
   }
@@ -0,0 +1,44 @@
+/**
+ * File: trace-seccomp.cc
+ * ----------------------
+ * Presents the implementation of the one function exported by trace-seccomp.h
+ */
+
+#include "trace-seccomp.h"
+#include <errno.h>
+#include <stddef.h> // for offsetof
+#include <string.h> // for strerror
+#include <string>
+#include <linux/audit.h>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+#include <sys/prctl.h>
+using namespace std;
+
+void installSystemCallFilter(const vector<int>& systemCallNumbers) throw (TraceException) {
+  // The filter is a chain of comparisons: one per system call that jumps
+  // ahead to the final RET_TRACE, falling through to RET_ALLOW otherwise.
+  // Anything other than a native x86_64 system call is allowed through, too.
+  vector<sock_filter> filter = {
+    BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, arch)),
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, AUDIT_ARCH_X86_64, 1, 0),
+    BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW),
+    BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, nr)),
+  };
+  size_t numCalls = systemCallNumbers.size();
+  if (numCalls > 255) throw TraceException("Too many system calls to filter (" + to_string(numCalls) + ")");
+  for (size_t i = 0; i < numCalls; i++) {
+    unsigned char toTrace = numCalls - i;  // instructions between this one and RET_TRACE
+    filter.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, (unsigned int) systemCallNumbers[i], toTrace, 0));
+  }
+  filter.push_back(BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW));
+  filter.push_back(BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_TRACE));
+
+  sock_fprog program = {(unsigned short) filter.size(), filter.data()};
+  // Unprivileged processes may only install filters once they've given up
+  // the right to gain privileges (through setuid executables, say).
+  if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) == -1 ||
+      prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &program) == -1) {
+    throw TraceException(string("Failed to install seccomp filter: ") + strerror(errno));
+  }
+}
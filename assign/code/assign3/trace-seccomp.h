@@ -0,0 +1,25 @@
+/**
+ * File: trace-seccomp.h
+ * ---------------------
+ * Exports a single routine that installs a seccomp-bpf filter so that only the
+ * system calls trace cares about stop the process.  Every other system call runs
+ * at full speed, without the two ptrace stops PTRACE_SYSCALL imposes on each one.
+ */
+
+#pragma once
+#include <vector>
+#include "trace-exception.h"
+
+/**
+ * Function: installSystemCallFilter
+ * ---------------------------------
+ * Installs, in the calling process, a seccomp filter that returns SECCOMP_RET_TRACE
+ * for each of the x86_64 system call numbers in systemCallNumbers and lets all others
+ * through.  The filter survives execvp, so the intended use is to call this in the
+ * child just before it execs the program being traced; the tracer then has to set
+ * PTRACE_O_TRACESECCOMP to receive a PTRACE_EVENT_SECCOMP stop for each traced call
+ * (a process with no tracer attached gets ENOSYS from them instead).
+ *
+ * Throws a TraceException if the filter can't be installed.
+ */
+void installSystemCallFilter(const std::vector<int>& systemCallNumbers) throw (TraceException);
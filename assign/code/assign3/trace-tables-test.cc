@@ -0,0 +1,73 @@
+/**
+ * File: trace-tables-test.cc
+ * --------------------------
+ * Exercises the TraceTables class by checking every entry against the maps
+ * compileSystemCallData and compileSystemCallErrorStrings build, and then
+ * printing the tables in the same format trace-system-calls-test does.
+ */
+
+#include "trace-tables.h"
+#include "trace-error-constants.h"
+#include <cassert>
+#include <iostream>
+using namespace std;
+
+static void checkTables(const TraceTables& tables) {
+  map<int, string> systemCallNumbers;
+  map<string, int> systemCallNames;
+  map<string, systemCallSignature> systemCallSignatures;
+  map<int, string> errorConstants;
+  compileSystemCallData(systemCallNumbers, systemCallNames, systemCallSignatures, /* rebuild = */ false);
+  compileSystemCallErrorStrings(errorConstants);
+
+  for (int number = -1; number <= tables.getNumSystemCalls(); number++) {
+    auto name = systemCallNumbers.find(number);
+    if (name == systemCallNumbers.end()) {
+      assert(tables.getSystemCallName(number) == NULL);
+      continue;
+    }
+    assert(name->second == tables.getSystemCallName(number));
+    assert(tables.getSystemCallNumber(name->second) == number);
+    auto signature = systemCallSignatures.find(name->second);
+    if (signature == systemCallSignatures.end()) {
+      assert(tables.getNumParameters(number) == -1);
+      continue;
+    }
+    assert(tables.getNumParameters(number) == int(signature->second.size()));
+    for (size_t i = 0; i < signature->second.size(); i++) {
+      assert(tables.getParameterType(number, i) == signature->second[i]);
+    }
+  }
+  assert(tables.getSystemCallNumber("no_such_system_call") == -1);
+
+  for (int errnum = -1; errnum <= 200; errnum++) {
+    auto constant = errorConstants.find(errnum);
+    if (constant == errorConstants.end()) assert(tables.getErrorConstant(errnum) == NULL);
+    else assert(constant->second == tables.getErrorConstant(errnum));
+  }
+}
+
+static void printTables(const TraceTables& tables) {
+  for (int number = 0; number < tables.getNumSystemCalls(); number++) {
+    const char *name = tables.getSystemCallName(number);
+    if (name == NULL) continue;
+    int numParameters = tables.getNumParameters(number);
+    if (numParameters < 0) {
+      cout << number << ": " << name << " isn't implemented." << endl;
+      continue;
+    }
+    cout << number << ": " << name << "(";
+    for (int i = 0; i < numParameters; i++) {
+      if (i > 0) cout << ", ";
+      cout << tables.getParameterType(number, i);
+    }
+    cout << ")" << endl;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  TraceTables tables(/* rebuild = */ false);
+  checkTables(tables);
+  printTables(tables);
+  return 0;
+}
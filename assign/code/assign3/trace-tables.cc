@@ -0,0 +1,240 @@
+/**
+ * File: trace-tables.cc
+ * ---------------------
+ * Presents the implementation of the TraceTables class.  The table file is laid out as
+ * a header followed by two arrays of fixed-size entries, one indexed by system call number
+ * and one indexed by errno value:
+ *
+ *    tablesHeader                         magic, source file stamps, and the lengths of the two arrays
+ *    systemCallEntry[numSystemCalls]      name and signature of each system call
+ *    errorEntry[numErrors]                #define constant of each errno value
+ *
+ * Unused entries have empty names.  The header records the size and modification time of
+ * every file the tables are built from, so an upgraded header file (or a rebuilt signature
+ * cache) is noticed and the tables are built again.
+ */
+
+#include "trace-tables.h"
+#include <cstdint>
+#include <cstdio> // for rename
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "trace-error-constants.h"
+using namespace std;
+
+static const char kMagic[8] = {'T', 'R', 'C', 'T', 'B', 'L', '0', '2'};
+static const int kMaxParameters = 6;
+
+/**
+ * Constant: kSourceFilenames
+ * --------------------------
+ * The files compileSystemCallData and compileSystemCallErrorStrings read.
+ */
+static const char *const kSourceFilenames[] = {
+  "/usr/include/x86_64-linux-gnu/asm/unistd_64.h",
+  "/usr/include/asm-generic/errno-base.h",
+  "/usr/include/asm-generic/errno.h",
+  ".trace_signatures.txt"
+};
+static const size_t kNumSourceFiles = sizeof(kSourceFilenames) / sizeof(kSourceFilenames[0]);
+
+struct sourceStamp {
+  int64_t size;    // -1 if the file doesn't exist
+  int64_t mtimeSeconds;
+  int64_t mtimeNanoseconds;
+};
+
+struct tablesHeader {
+  char magic[sizeof(kMagic)];
+  sourceStamp sources[kNumSourceFiles];
+  int32_t numSystemCalls;
+  int32_t numErrors;
+};
+
+struct systemCallEntry {
+  char name[32];
+  int8_t numParameters;  // -1 if the signature isn't known
+  uint8_t parameterTypes[kMaxParameters + 1];
+};
+
+struct errorEntry {
+  char name[24];
+};
+
+/**
+ * Function: copyName
+ * ------------------
+ * Copies name into a fixed-size entry field, throwing a TraceException if it won't fit.
+ */
+template <size_t N>
+static void copyName(char (&field)[N], const string& name) throw (TraceException) {
+  if (name.size() >= N) throw TraceException("The name \"" + name + "\" is too long for " + kTraceTablesFilename);
+  strncpy(field, name.c_str(), N);
+}
+
+/**
+ * Function: stampSources
+ * ----------------------
+ * Records the current size and modification time of every file in kSourceFilenames.
+ */
+static void stampSources(sourceStamp stamps[]) {
+  for (size_t i = 0; i < kNumSourceFiles; i++) {
+    struct stat st;
+    memset(&stamps[i], 0, sizeof(stamps[i]));
+    if (stat(kSourceFilenames[i], &st) == -1) {
+      stamps[i].size = -1;
+      continue;
+    }
+    stamps[i].size = st.st_size;
+    stamps[i].mtimeSeconds = st.st_mtim.tv_sec;
+    stamps[i].mtimeNanoseconds = st.st_mtim.tv_nsec;
+  }
+}
+
+/**
+ * Function: buildTables
+ * ---------------------
+ * Runs the existing parsers once and flattens what they find into image, laid out
+ * exactly as the table file is.
+ */
+static void buildTables(bool rebuild, vector<char>& image) throw (TraceException) {
+  map<int, string> systemCallNumbers;
+  map<string, int> systemCallNames;
+  map<string, systemCallSignature> systemCallSignatures;
+  map<int, string> errorConstants;
+  compileSystemCallData(systemCallNumbers, systemCallNames, systemCallSignatures, rebuild);
+  compileSystemCallErrorStrings(errorConstants);
+
+  tablesHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  stampSources(header.sources);  // after the parsers, which may have just rewritten the signature cache
+  header.numSystemCalls = systemCallNumbers.empty() ? 0 : systemCallNumbers.rbegin()->first + 1;
+  header.numErrors = errorConstants.empty() ? 0 : errorConstants.rbegin()->first + 1;
+
+  vector<systemCallEntry> systemCalls(header.numSystemCalls);
+  for (const pair<const int, string>& p: systemCallNumbers) {
+    systemCallEntry& entry = systemCalls[p.first];
+    copyName(entry.name, p.second);
+    auto found = systemCallSignatures.find(p.second);
+    if (found == systemCallSignatures.end() || found->second.size() > size_t(kMaxParameters)) {
+      entry.numParameters = -1;
+      continue;
+    }
+    entry.numParameters = found->second.size();
+    for (size_t i = 0; i < found->second.size(); i++) entry.parameterTypes[i] = found->second[i];
+  }
+
+  vector<errorEntry> errors(header.numErrors);
+  for (const pair<const int, string>& p: errorConstants) copyName(errors[p.first].name, p.second);
+
+  const char *headerBytes = reinterpret_cast<const char *>(&header);
+  const char *systemCallBytes = reinterpret_cast<const char *>(systemCalls.data());
+  const char *errorBytes = reinterpret_cast<const char *>(errors.data());
+  image.assign(headerBytes, headerBytes + sizeof(header));
+  image.insert(image.end(), systemCallBytes, systemCallBytes + systemCalls.size() * sizeof(systemCallEntry));
+  image.insert(image.end(), errorBytes, errorBytes + errors.size() * sizeof(errorEntry));
+}
+
+/**
+ * Function: saveTables
+ * --------------------
+ * Writes image to kTraceTablesFilename so later runs can map it.  The file is written
+ * under a temporary name and then renamed, so a concurrent trace never maps a
+ * half-written table.  Failing to write it (say, because the working directory isn't
+ * writable) is no problem, just like failing to write the signature cache: this run
+ * uses image itself, and the next run builds the tables again.
+ */
+static void saveTables(const vector<char>& image) {
+  const string tempFilename = kTraceTablesFilename + "." + to_string(getpid());
+  ofstream outfile(tempFilename, ios::binary);
+  if (outfile.fail()) return;
+  outfile.write(image.data(), image.size());
+  outfile.close();
+  if (outfile.fail() || rename(tempFilename.c_str(), kTraceTablesFilename.c_str()) != 0) {
+    unlink(tempFilename.c_str());
+  }
+}
+
+/**
+ * Function: mapTables
+ * -------------------
+ * Maps kTraceTablesFilename into memory and returns its address, setting size to its
+ * length, or returns NULL if it doesn't exist, is obviously not a table file, or was
+ * built from different versions of the source files.
+ */
+static const void *mapTables(size_t& size) {
+  int fd = open(kTraceTablesFilename.c_str(), O_RDONLY);
+  if (fd == -1) return NULL;
+  struct stat st;
+  void *image = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(tablesHeader)) {
+    size = st.st_size;
+    image = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (image == MAP_FAILED) return NULL;
+
+  const tablesHeader *header = static_cast<const tablesHeader *>(image);
+  sourceStamp stamps[kNumSourceFiles];
+  stampSources(stamps);
+  if (memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || memcmp(header->sources, stamps, sizeof(stamps)) != 0 ||
+      header->numSystemCalls < 0 || header->numErrors < 0 ||
+      size != sizeof(tablesHeader) + header->numSystemCalls * sizeof(systemCallEntry) + header->numErrors * sizeof(errorEntry)) {
+    munmap(image, size);
+    return NULL;
+  }
+  return image;
+}
+
+TraceTables::TraceTables(bool rebuild) throw (TraceException) {
+  image = rebuild ? NULL : mapTables(imageSize);
+  if (image == NULL) {
+    buildTables(rebuild, builtImage);
+    saveTables(builtImage);
+    image = builtImage.data();
+    imageSize = 0;  // nothing to unmap
+  }
+
+  const tablesHeader *header = static_cast<const tablesHeader *>(image);
+  numSystemCalls = header->numSystemCalls;
+  numErrors = header->numErrors;
+  systemCalls = reinterpret_cast<const systemCallEntry *>(header + 1);
+  errors = reinterpret_cast<const errorEntry *>(systemCalls + numSystemCalls);
+}
+
+TraceTables::~TraceTables() {
+  if (imageSize > 0) munmap(const_cast<void *>(image), imageSize);
+}
+
+const char *TraceTables::getSystemCallName(int number) const {
+  if (number < 0 || number >= numSystemCalls || systemCalls[number].name[0] == '\0') return NULL;
+  return systemCalls[number].name;
+}
+
+int TraceTables::getSystemCallNumber(const string& name) const {
+  for (int number = 0; number < numSystemCalls; number++) {
+    if (name == systemCalls[number].name) return number;
+  }
+  return -1;
+}
+
+int TraceTables::getNumParameters(int number) const {
+  if (getSystemCallName(number) == NULL) return -1;
+  return systemCalls[number].numParameters;
+}
+
+scParamType TraceTables::getParameterType(int number, int i) const {
+  if (i < 0 || i >= getNumParameters(number)) return SYSCALL_UNKNOWN_TYPE;
+  return scParamType(systemCalls[number].parameterTypes[i]);
+}
+
+const char *TraceTables::getErrorConstant(int errnum) const {
+  if (errnum < 0 || errnum >= numErrors || errors[errnum].name[0] == '\0') return NULL;
+  return errors[errnum].name;
+}
@@ -0,0 +1,88 @@
+/**
+ * File: trace-tables.h
+ * --------------------
+ * Exports a class that presents everything trace needs to know about system calls and errno
+ * values as flat arrays indexed by system call number and errno value.
+ *
+ * compileSystemCallData and compileSystemCallErrorStrings parse header files (and the
+ * signature cache) with regular expressions, which takes far longer than tracing a short
+ * program does.  So the first time trace runs, TraceTables runs them once and writes what
+ * they find to a compact binary file; every run after that just maps the file into memory
+ * (until one of the files it was built from changes), and each lookup in the trace loop is
+ * an array index rather than a map<string, ...> search.
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include "trace-system-calls.h"
+#include "trace-exception.h"
+
+/**
+ * Constant: kTraceTablesFilename
+ * ------------------------------
+ * Names the binary file the tables are kept in, alongside the signature cache.
+ */
+static const std::string kTraceTablesFilename = ".trace_tables.bin";
+
+class TraceTables {
+  public:
+    /**
+     * Constructor: TraceTables
+     * ------------------------
+     * Maps kTraceTablesFilename into memory, first building it if it doesn't exist yet,
+     * isn't a valid table file, is older than the files it's built from, or rebuild is true
+     * (in which case the signatures are rebuilt from scratch too, just as
+     * compileSystemCallData would do).  If the file can't be written, the tables built
+     * are used from memory instead.
+     *
+     * Throws a TraceException if the tables can't be built.
+     */
+    TraceTables(bool rebuild) throw (TraceException);
+    ~TraceTables();
+
+    /**
+     * Method: getNumSystemCalls
+     * -------------------------
+     * Returns one more than the largest system call number the tables know about.
+     */
+    int getNumSystemCalls() const { return numSystemCalls; }
+
+    /**
+     * Methods: getSystemCallName, getSystemCallNumber
+     * -----------------------------------------------
+     * Map system call numbers to names and back again.  getSystemCallName returns NULL
+     * for an unknown number, and getSystemCallNumber returns -1 for an unknown name.
+     */
+    const char *getSystemCallName(int number) const;
+    int getSystemCallNumber(const std::string& name) const;
+
+    /**
+     * Methods: getNumParameters, getParameterType
+     * -------------------------------------------
+     * Describe the signature of the system call with the specified number.
+     * getNumParameters returns -1 if the signature isn't known.
+     */
+    int getNumParameters(int number) const;
+    scParamType getParameterType(int number, int i) const;
+
+    /**
+     * Method: getErrorConstant
+     * ------------------------
+     * Returns the #define constant (e.g. "ENOENT") for an errno value (e.g. 2),
+     * or NULL if there isn't one.
+     */
+    const char *getErrorConstant(int errnum) const;
+
+  private:
+    const void *image;
+    size_t imageSize;             // of the mapping, or 0 if image points into builtImage
+    std::vector<char> builtImage; // the tables, if they had to be built this run
+    int numSystemCalls;
+    int numErrors;
+    const struct systemCallEntry *systemCalls;
+    const struct errorEntry *errors;
+
+    TraceTables(const TraceTables& original) = delete;
+    TraceTables& operator=(const TraceTables& rhs) = delete;
+};
@@ -12,7 +12,6 @@
 
 #include <cassert>
 #include <iostream>
-#include <map>
 #include <set>
 #include <unistd.h> // for fork, execvp
 #include <signal.h>
@@ -23,12 +22,15 @@
 #include <sys/reg.h>
 #include <sys/wait.h>
 #include "trace-options.h"
-#include "trace-error-constants.h"
 #include "trace-system-calls.h"
+#include "trace-tables.h"
 #include "trace-exception.h"
+#include "trace-memory.h"
+#include "trace-seccomp.h"
 using namespace std;
 
 #define SIGTRAP2 (SIGTRAP | 0x80)
+#define SECCOMP_STOP (SIGTRAP | (PTRACE_EVENT_SECCOMP << 8))
 
 typedef int regtype;
 
@@ -37,19 +39,34 @@ static const set<string> voidStarReturns = {"brk", "sbrk", "mmap"};
 
 int main(int argc, char *argv[]) {
   bool simple = false, rebuild = false;
-  int numFlags = processCommandLineFlags(simple, rebuild, argv);
+  vector<string> onlySystemCalls;
+  int numFlags = processCommandLineFlags(simple, rebuild, onlySystemCalls, argv);
   if (argc - numFlags == 1) {
     cout << "Nothing to trace... exiting." << endl;
     return 0;
   }
 
   int trueArgvIndex = numFlags+1;
-  map<int, std::string> systemCallNumbers;
-  map<std::string, int> systemCallNames;
-  map<std::string, systemCallSignature> systemCallSignatures;
-  map<int, std::string> errorConstants;
-  compileSystemCallData(systemCallNumbers, systemCallNames, systemCallSignatures, rebuild);
-  compileSystemCallErrorStrings(errorConstants);
+  TraceTables tables(rebuild);
+  vector<bool> returnsVoidStar(tables.getNumSystemCalls());
+  for (const string& name: voidStarReturns) {
+    int number = tables.getSystemCallNumber(name);
+    if (number >= 0) returnsVoidStar[number] = true;
+  }
+
+  // With --only, a seccomp filter stops the child for just the listed system
+  // calls, and the child otherwise runs untraced between them.
+  bool only = !onlySystemCalls.empty();
+  vector<int> onlySystemCallNumbers;
+  for (const string& name: onlySystemCalls) {
+    int number = tables.getSystemCallNumber(name);
+    if (number < 0) {
+      fprintf(stderr, "Unknown system call %s.\n", name.c_str());
+      return 1;
+    }
+    onlySystemCallNumbers.push_back(number);
+  }
+  enum __ptrace_request resume = only ? PTRACE_CONT : PTRACE_SYSCALL;
 
   int pid = fork();
   if (pid < 0) {
@@ -60,31 +77,42 @@ int main(int argc, char *argv[]) {
   if (pid == 0) {
     ptrace(PTRACE_TRACEME);
     raise(SIGSTOP);
+    if (only) {
+      try {
+        installSystemCallFilter(onlySystemCallNumbers);
+      } catch (const TraceException& te) {
+        cerr << te.what() << endl;
+        _exit(1);
+      }
+    }
     execvp(argv[trueArgvIndex], argv+trueArgvIndex);
   } else {
     waitpid(pid, NULL, 0);
-    ptrace(PTRACE_SETOPTIONS, pid, 0, PTRACE_O_TRACESYSGOOD);
-    ptrace(PTRACE_SYSCALL, pid, 0, 0);
+    ptrace(PTRACE_SETOPTIONS, pid, 0, PTRACE_O_TRACESYSGOOD | (only ? PTRACE_O_TRACESECCOMP : 0));
+    ptrace(resume, pid, 0, 0);
 
     int status;
     while (true) {
       waitpid(pid, &status, 0);
       if (WIFEXITED(status)) {
         break;
-      } else if (WIFSTOPPED(status) && WSTOPSIG(status) == SIGTRAP2) {
+      } else if (WIFSTOPPED(status) && (only ? status >> 8 == SECCOMP_STOP : WSTOPSIG(status) == SIGTRAP2)) {
+        // Either way, the system call is about to be made; PTRACE_SYSCALL
+        // then stops the child again once it returns.
         int sysCallNum = ptrace(PTRACE_PEEKUSER, pid, ORIG_RAX * sizeof(long));
-        const string sysCallName = systemCallNumbers[sysCallNum];
+        const char *sysCallName = tables.getSystemCallName(sysCallNum);
+        if (sysCallName == NULL) sysCallName = "";
 
         if (!simple) {
           vector<string> stringArgs;
-          if (systemCallSignatures.find(sysCallName) == systemCallSignatures.end()) {
+          int numParameters = tables.getNumParameters(sysCallNum);
+          if (numParameters < 0) {
             stringArgs.push_back("<signature-information-missing>");
           }
           else {
-            const systemCallSignature sysCallSig = systemCallSignatures[sysCallName];
-            for (size_t i=0; i<sysCallSig.size(); i++) {
+            for (int i=0; i<numParameters; i++) {
               long regVal = ptrace(PTRACE_PEEKUSER, pid, argRegisters[i] * sizeof(long));
-              switch (sysCallSig[i]) {
+              switch (tables.getParameterType(sysCallNum, i)) {
                 case SYSCALL_INTEGER:
                   stringArgs.push_back(to_string((int) regVal));
                   break;
@@ -94,22 +122,7 @@ int main(int argc, char *argv[]) {
                     break;
                   }
                   // regVal points to a null terminated string
-                  string res = "\"";
-                  while (true) {
-                    bool done = false;
-                    long regStr = ptrace(PTRACE_PEEKDATA, pid, regVal);
-                    for (size_t j=0; j<sizeof(long); j++) {
-                      char ch = ((char *) &regStr)[j];
-                      res += ch;
-                      if (ch == '\0') {
-                        done = true;
-                        break;
-                      }
-                    }
-                    regVal += sizeof(long);
-                    if (done) break;
-                  }
-                  res += "\"";
+                  string res = "\"" + readTraceeString(pid, regVal) + "\"";
                   stringArgs.push_back(res);
                   break;
                 }
@@ -148,18 +161,19 @@ int main(int argc, char *argv[]) {
           if (retval < 0) {
             retval = abs(retval);
             cout << "-1";
-            if (!simple && errorConstants.find(retval) != errorConstants.end())
-              cout << " " << errorConstants[retval] << " (" << strerror(retval) << ")";
-          } else if (voidStarReturns.find(sysCallName) != voidStarReturns.end()) {
+            const char *errorConstant = tables.getErrorConstant(retval);
+            if (!simple && errorConstant != NULL)
+              cout << " " << errorConstant << " (" << strerror(retval) << ")";
+          } else if (sysCallNum >= 0 && sysCallNum < tables.getNumSystemCalls() && returnsVoidStar[sysCallNum]) {
             cout << (void *) retval;
           } else {
             cout << (int) retval;
           }
         }
         cout << endl;
-        ptrace(PTRACE_SYSCALL, pid, 0, 0);
+        ptrace(resume, pid, 0, 0);
       } else {
-        ptrace(PTRACE_SYSCALL, pid, 0, 0);
+        ptrace(resume, pid, 0, 0);
       }
     }
 